@@ -13,6 +13,9 @@
 #include "functor.h"
 #include "hash_function.h"
 #include "hash_table.h"
+#include "flat_hash_table.h"
+#include "instrumented_allocator.h"
+#include "pool_allocator.h"
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -20,12 +23,26 @@
 #include <map>
 #include "slist.h"
 #include "graph.h"
+#include "small_vector.h"
+#include "mapped_vector.h"
+#include "hive.h"
+#include "unrolled_list.h"
 #include "deque.h"
 #include "queue.h"
 #include "index_priority_queue.h"
 #include "quick_sort_nonrecursive.h"
 #include <assert.h>
 #include <set>
+#include <vector>
+#include <queue>
+#if defined(__MYSTL_CXX11)
+#include <thread>
+#include <chrono>
+#include "thread_cache_allocator.h"
+#include "concurrent_queue.h"
+#include "work_stealing_deque.h"
+#include "thread_pool.h"
+#endif
 
 using MySTL::hashtable;
 using MySTL::hash;
@@ -39,6 +56,10 @@ using MySTL::deque;
 using MySTL::queue;
 using MySTL::priority_queue;
 using MySTL::index_priority_queue;
+using MySTL::type_allocator;
+using MySTL::instrumented_allocator;
+using MySTL::hashtable_alloc_tag;
+using MySTL::pool_allocator;
 
 typedef MySTL::AVL_tree<int,int,identity<int>,less<int> > tree;
 
@@ -67,6 +88,731 @@ int power(int x, int n)
 	return r;
 }
 
+double seconds_since(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// node churn: lists filled and emptied again with a node allocator
+template <class Alloc>
+double time_list_churn()
+{
+	typedef MySTL::list<int, type_allocator<MySTL::__list_node<int>, Alloc> > List;
+	clock_t start = clock();
+	for (int r = 0; r < 200; ++r)
+	{
+		List l;
+		for (int i = 0; i < 10000; ++i)
+			l.push_back(i);
+		while (!l.empty())
+			l.pop_front();
+	}
+	return seconds_since(start);
+}
+
+void bench_node_allocators()
+{
+	printf("list node churn, allocator : %.3fs\n", time_list_churn<MySTL::allocator>());
+	printf("list node churn, pool_allocator : %.3fs\n", time_list_churn<pool_allocator>());
+	printf("list node churn, single_client_pool_allocator : %.3fs\n",
+		   time_list_churn<MySTL::single_client_pool_allocator>());
+}
+
+// vector growth: MySTL::vector<int> grows through allocator::reallocate,
+// std::vector copies into every new block
+template <class Vector>
+double time_int_growth()
+{
+	clock_t start = clock();
+	for (int r = 0; r < 10; ++r)
+	{
+		Vector v;
+		for (int i = 0; i < 4000000; ++i)
+			v.push_back(i);
+	}
+	return seconds_since(start);
+}
+
+void bench_vector_growth()
+{
+	printf("vector<int> growth, MySTL::vector : %.3fs, std::vector : %.3fs\n",
+		   time_int_growth<MySTL::vector<int> >(), time_int_growth<std::vector<int> >());
+}
+
+// an edge with a user-declared copy constructor takes the element by
+// element paths that every edge took before the traits were derived
+struct copied_edge : public edge
+{
+	copied_edge(int v = -1, int w = -1, float wei = 0.0f) : edge(v, w, wei) {}
+	copied_edge(const copied_edge& x) : edge(x) {}
+};
+
+template <class Edge>
+double time_edge_copy_and_growth()
+{
+	clock_t start = clock();
+	for (int r = 0; r < 10; ++r)
+	{
+		MySTL::vector<Edge> edges;
+		for (int i = 0; i < 1000000; ++i)
+			edges.push_back(Edge(i, i + 1, 1.0f));
+		MySTL::vector<Edge> copy(edges);
+		edges.insert(edges.begin(), copy.begin(), copy.begin() + 1000);
+	}
+	return seconds_since(start);
+}
+
+void bench_edge_vector()
+{
+	printf("vector<edge> copy and growth, edge : %.3fs, with copy constructor : %.3fs\n",
+		   time_edge_copy_and_growth<edge>(), time_edge_copy_and_growth<copied_edge>());
+}
+
+// peak resident set size in MB since the last reset_peak_rss(), 0 where
+// the system does not tell (Linux only)
+void reset_peak_rss()
+{
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	if (f)
+	{
+		fputs("5", f);
+		fclose(f);
+	}
+#endif
+}
+
+long peak_rss_mb()
+{
+	long kb = 0;
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/status", "r");
+	char line[128];
+	while (f && fgets(line, sizeof(line), f))
+	{
+		if (sscanf(line, "VmHWM: %ld kB", &kb) == 1)
+			break;
+	}
+	if (f)
+		fclose(f);
+#endif
+	return kb / 1024;
+}
+
+// 30M push_backs of int; mapped_vector runs first so its peak is right
+// even where the peak cannot be reset
+template <class Vector>
+double time_big_push_back(long& peak_mb)
+{
+	reset_peak_rss();
+	clock_t start = clock();
+	{
+		Vector v;
+		for (int i = 0; i < 30000000; ++i)
+			v.push_back(i);
+		peak_mb = peak_rss_mb();
+	}
+	return seconds_since(start);
+}
+
+void bench_mapped_vector()
+{
+	long mapped_peak, vector_peak, std_peak;
+	double mapped_time = time_big_push_back<MySTL::mapped_vector<int> >(mapped_peak);
+	double vector_time = time_big_push_back<MySTL::vector<int> >(vector_peak);
+	double std_time = time_big_push_back<std::vector<int> >(std_peak);
+	printf("30M push_back, mapped_vector : %.3fs peak %ldMB, vector : %.3fs peak %ldMB, "
+		   "std::vector : %.3fs peak %ldMB\n",
+		   mapped_time, mapped_peak, vector_time, vector_peak, std_time, std_peak);
+}
+
+// insert/erase/iterate mix: 200000 inserts, every third element erased
+// through a kept iterator, 100000 inserts into the holes, ten full scans
+MySTL::list<int>::iterator insert_one(MySTL::list<int>& c, int x)
+{
+	c.push_back(x);
+	return --c.end();
+}
+
+MySTL::hive<int>::iterator insert_one(MySTL::hive<int>& c, int x)
+{
+	return c.insert(x);
+}
+
+template <class Container>
+double time_insert_erase_iterate(long long& sum)
+{
+	clock_t start = clock();
+	Container c;
+	MySTL::vector<typename Container::iterator> kept;
+	for (int i = 0; i < 200000; ++i)
+		kept.push_back(insert_one(c, i));
+	for (size_t i = 0; i < kept.size(); i += 3)
+		c.erase(kept[i]);
+	for (int i = 0; i < 100000; ++i)
+		insert_one(c, i);
+	sum = 0;
+	for (int r = 0; r < 10; ++r)
+	{
+		for (typename Container::iterator it = c.begin(); it != c.end(); ++it)
+			sum += *it;
+	}
+	return seconds_since(start);
+}
+
+void bench_hive()
+{
+	long long list_sum, hive_sum;
+	double list_time = time_insert_erase_iterate<MySTL::list<int> >(list_sum);
+	double hive_time = time_insert_erase_iterate<MySTL::hive<int> >(hive_sum);
+	printf("insert/erase/iterate, list : %.3fs, hive : %.3fs%s\n",
+		   list_time, hive_time, list_sum == hive_sum ? "" : " (sums differ)");
+}
+
+// unrolled_list against list: ten scans of 1M ints, 200000 inserts in the
+// middle of 100000 ints at the position the last insert returned, and a
+// SeqST of 5000 random keys filled and searched
+template <class List>
+double time_list_scans(long long& sum)
+{
+	List l;
+	for (int i = 0; i < 1000000; ++i)
+		l.push_back(i);
+	clock_t start = clock();
+	sum = 0;
+	for (int r = 0; r < 10; ++r)
+	{
+		for (typename List::iterator it = l.begin(); it != l.end(); ++it)
+			sum += *it;
+	}
+	return seconds_since(start);
+}
+
+template <class List>
+double time_middle_inserts()
+{
+	clock_t start = clock();
+	List l;
+	for (int i = 0; i < 100000; ++i)
+		l.push_back(i);
+	typename List::iterator pos = l.begin();
+	for (int i = 0; i < 50000; ++i)
+		++pos;
+	for (int i = 0; i < 200000; ++i)
+		pos = l.insert(pos, i);
+	return seconds_since(start);
+}
+
+template <class Table>
+double time_seqst(int& found)
+{
+	clock_t start = clock();
+	Table st;
+	srand(2);
+	for (int i = 0; i < 5000; ++i)
+	{
+		int key = rand() % 20000;
+		st.put(key, i);
+	}
+	found = 0;
+	for (int i = 0; i < 5000; ++i)
+	{
+		if (st.get(rand() % 20000) != st.end())
+			++found;
+	}
+	return seconds_since(start);
+}
+
+void bench_unrolled_list()
+{
+	typedef MySTL::unrolled_list<int> UnrolledList;
+	typedef MySTL::SeqST<int, int, MySTL::unrolled_list<pair<int, int> > > UnrolledSeqST;
+	long long sum;
+	int found;
+	double list_scan = time_list_scans<MySTL::list<int> >(sum);
+	double unrolled_scan = time_list_scans<UnrolledList>(sum);
+	printf("1M element scans, list : %.3fs, unrolled_list : %.3fs\n", list_scan, unrolled_scan);
+	printf("middle inserts, list : %.3fs, unrolled_list : %.3fs\n",
+		   time_middle_inserts<MySTL::list<int> >(), time_middle_inserts<UnrolledList>());
+	double list_st = time_seqst<MySTL::SeqST<int, int> >(found);
+	double unrolled_st = time_seqst<UnrolledSeqST>(found);
+	printf("SeqST put/get, list : %.3fs, unrolled_list : %.3fs\n", list_st, unrolled_st);
+}
+
+// queue push/pop in million operations per second: a queue of 1000 ints
+// sliding through 10M push/pop pairs (every block is emptied and needed
+// again), then ten fills and drains of 1M ints
+template <class Queue>
+double queue_push_pop_rate(long long& sum)
+{
+	clock_t start = clock();
+	Queue q;
+	sum = 0;
+	for (int i = 0; i < 1000; ++i)
+		q.push(i);
+	for (int i = 0; i < 10000000; ++i)
+	{
+		q.push(i);
+		sum += q.front();
+		q.pop();
+	}
+	for (int r = 0; r < 10; ++r)
+	{
+		for (int i = 0; i < 1000000; ++i)
+			q.push(i);
+		while (!q.empty())
+		{
+			sum += q.front();
+			q.pop();
+		}
+	}
+	return 2 * (10000000 + 10 * 1000000 + 1000) / seconds_since(start) / 1e6;
+}
+
+// BFS over a 1000 x 1000 grid from a corner, 20 times: pop a cell, push
+// its unvisited neighbours; the queue holds about one diagonal at a time
+template <class Queue>
+double time_grid_bfs(long long& visited)
+{
+	const int side = 1000;
+	clock_t start = clock();
+	visited = 0;
+	for (int r = 0; r < 20; ++r)
+	{
+		MySTL::vector<char> seen(side * side, 0);
+		Queue q;
+		q.push(0);
+		seen[0] = 1;
+		while (!q.empty())
+		{
+			int cell = q.front();
+			q.pop();
+			++visited;
+			int x = cell % side, y = cell / side;
+			if (x + 1 < side && !seen[cell + 1])
+			{
+				seen[cell + 1] = 1;
+				q.push(cell + 1);
+			}
+			if (y + 1 < side && !seen[cell + side])
+			{
+				seen[cell + side] = 1;
+				q.push(cell + side);
+			}
+			if (x > 0 && !seen[cell - 1])
+			{
+				seen[cell - 1] = 1;
+				q.push(cell - 1);
+			}
+			if (y > 0 && !seen[cell - side])
+			{
+				seen[cell - side] = 1;
+				q.push(cell - side);
+			}
+		}
+	}
+	return seconds_since(start);
+}
+
+void bench_bfs_queue()
+{
+	long long visited;
+	double deque_time = time_grid_bfs<queue<int> >(visited);
+	double ring_time = time_grid_bfs<queue<int, MySTL::circular_buffer<int> > >(visited);
+	printf("grid BFS, queue over deque : %.3fs, over circular_buffer : %.3fs\n", deque_time, ring_time);
+	long long sum;
+	double deque_rate = queue_push_pop_rate<queue<int> >(sum);
+	double ring_rate = queue_push_pop_rate<queue<int, MySTL::circular_buffer<int> > >(sum);
+	printf("queue<int> push/pop Mops/s, over deque : %.1f, over circular_buffer : %.1f\n", deque_rate, ring_rate);
+}
+
+void bench_queue()
+{
+	long long sum;
+	double mystl_rate = queue_push_pop_rate<queue<int> >(sum);
+	double std_rate = queue_push_pop_rate<std::queue<int> >(sum);
+	printf("queue<int> push/pop Mops/s, MySTL::queue : %.1f, std::queue : %.1f\n", mystl_rate, std_rate);
+}
+
+// sparse digraph with two out-edges per vertex on average, built 20 times,
+// counting the allocations of the adjacency lists
+struct adjacency_alloc_tag { static const char* name() { return "adjacency"; } };
+typedef instrumented_allocator<adjacency_alloc_tag> AdjacencyCounter;
+typedef type_allocator<int, AdjacencyCounter> AdjacencyAllocator;
+
+template <class Adjacency>
+double time_sparse_graph_build(size_t& allocations)
+{
+	const int V = 30000;
+	size_t before = AdjacencyCounter::stats().m_allocations;
+	srand(1);
+	clock_t start = clock();
+	for (int r = 0; r < 20; ++r)
+	{
+		MySTL::vector<Adjacency> adj(V);
+		for (int e = 0; e < 2 * V; ++e)
+			adj[rand() % V].push_back(rand() % V);
+	}
+	allocations = AdjacencyCounter::stats().m_allocations - before;
+	return seconds_since(start);
+}
+
+void bench_sparse_graph()
+{
+	size_t vector_allocs, small_allocs;
+	double vector_time = time_sparse_graph_build<MySTL::vector<int, AdjacencyAllocator> >(vector_allocs);
+	double small_time = time_sparse_graph_build<MySTL::small_vector<int, 4, AdjacencyAllocator> >(small_allocs);
+	printf("sparse graph build, vector : %.3fs %u allocs, small_vector<int, 4> : %.3fs %u allocs\n",
+		   vector_time, (unsigned)vector_allocs, small_time, (unsigned)small_allocs);
+}
+
+#if defined(__MYSTL_CXX11)
+// strings too long for the small string buffer, pushed as copies or moved in
+double time_string_fill(bool move)
+{
+	clock_t start = clock();
+	for (int r = 0; r < 10; ++r)
+	{
+		MySTL::vector<std::string> v;
+		for (int i = 0; i < 200000; ++i)
+		{
+			std::string s(40, (char)('a' + i % 26));
+			if (move)
+				v.push_back(MySTL::move(s));
+			else
+				v.push_back(s);
+		}
+	}
+	return seconds_since(start);
+}
+
+void bench_vector_move()
+{
+	printf("vector<std::string> fill, copy : %.3fs, move : %.3fs\n",
+		   time_string_fill(false), time_string_fill(true));
+}
+#endif
+
+#if defined(__MYSTL_CXX11)
+// clock() adds up the cpu time of all threads, threaded runs are timed
+// by the wall clock
+double wall_seconds()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 1, 2, 4 ... threads up to the hardware threads
+int next_thread_count(int threads)
+{
+	int most = (int)std::thread::hardware_concurrency();
+	if (threads >= most)
+		return 0;
+	return threads * 2 < most ? threads * 2 : most;
+}
+
+template <class Alloc>
+void alloc_free_worker(int rounds)
+{
+	void* blocks[64];
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (int i = 0; i < 64; ++i)
+			blocks[i] = Alloc::allocate(48);
+		for (int i = 0; i < 64; ++i)
+			Alloc::deallocate(blocks[i], 48);
+	}
+}
+
+// million allocate/deallocate pairs per second with every thread busy
+template <class Alloc>
+double alloc_free_rate(int threads)
+{
+	const int rounds = 20000;
+	std::thread workers[256];
+	double start = wall_seconds();
+	for (int t = 0; t < threads; ++t)
+		workers[t] = std::thread(alloc_free_worker<Alloc>, rounds);
+	for (int t = 0; t < threads; ++t)
+		workers[t].join();
+	return threads * rounds * 64.0 / (wall_seconds() - start) / 1e6;
+}
+
+// spsc_queue: the producer pushes 0 .. n-1 in batches, the consumer pops
+// in batches and checks the order; million elements per second
+void spsc_producer(MySTL::spsc_queue<int>* q, int n, size_t batch)
+{
+	int buf[64];
+	for (int i = 0; i < n; )
+	{
+		size_t k = 0;
+		for ( ; k < batch && i + (int)k < n; ++k)
+			buf[k] = i + (int)k;
+		for (size_t pushed = 0; pushed < k; )
+		{
+			size_t m = q->try_push_n(buf + pushed, k - pushed);
+			if (m == 0)
+				std::this_thread::yield();
+			pushed += m;
+		}
+		i += (int)k;
+	}
+}
+
+double spsc_rate(size_t batch, bool& in_order)
+{
+	const int n = 2000000;
+	MySTL::spsc_queue<int> q(1024);
+	int buf[64];
+	int expected = 0;
+	in_order = true;
+	double start = wall_seconds();
+	std::thread producer(spsc_producer, &q, n, batch);
+	while (expected < n)
+	{
+		size_t m = q.try_pop_n(buf, batch);
+		if (m == 0)
+			std::this_thread::yield();
+		for (size_t j = 0; j < m; ++j)
+		{
+			if (buf[j] != expected++)
+				in_order = false;
+		}
+	}
+	producer.join();
+	return n / (wall_seconds() - start) / 1e6;
+}
+
+// mpmc_queue: every producer pushes its own n values, the consumers pop
+// until all are taken; afterwards every value must have been seen exactly
+// once, and the values of one producer in the order it pushed them
+void mpmc_producer(MySTL::mpmc_queue<int>* q, int id, int n)
+{
+	for (int i = 0; i < n; ++i)
+	{
+		while (!q->try_push(id * n + i))
+			std::this_thread::yield();
+	}
+}
+
+void mpmc_consumer(MySTL::mpmc_queue<int>* q, std::atomic<int>* remaining, MySTL::vector<int>* got)
+{
+	int x;
+	while (remaining->load(std::memory_order_relaxed) > 0)
+	{
+		if (q->try_pop(x))
+		{
+			got->push_back(x);
+			remaining->fetch_sub(1, std::memory_order_relaxed);
+		}
+		else
+			std::this_thread::yield();
+	}
+}
+
+double mpmc_rate(int threads, bool& exact)
+{
+	const int n = 200000;
+	MySTL::mpmc_queue<int> q(1024);
+	std::atomic<int> remaining(threads * n);
+	MySTL::vector<int> got[128];
+	std::thread producers[128], consumers[128];
+	double start = wall_seconds();
+	for (int t = 0; t < threads; ++t)
+	{
+		producers[t] = std::thread(mpmc_producer, &q, t, n);
+		consumers[t] = std::thread(mpmc_consumer, &q, &remaining, &got[t]);
+	}
+	for (int t = 0; t < threads; ++t)
+	{
+		producers[t].join();
+		consumers[t].join();
+	}
+	double rate = threads * n / (wall_seconds() - start) / 1e6;
+
+	MySTL::vector<int> seen(threads * n, 0);
+	exact = true;
+	for (int t = 0; t < threads; ++t)
+	{
+		MySTL::vector<int> last(threads, -1);
+		for (size_t i = 0; i < got[t].size(); ++i)
+		{
+			int x = got[t][i];
+			if (++seen[x] != 1 || x <= last[x / n])
+				exact = false;
+			last[x / n] = x;
+		}
+	}
+	for (int i = 0; i < threads * n; ++i)
+	{
+		if (seen[i] != 1)
+			exact = false;
+	}
+	return rate;
+}
+
+void bench_concurrent_queues()
+{
+	bool ok;
+	double single = spsc_rate(1, ok);
+	bool batched_ok;
+	double batched = spsc_rate(64, batched_ok);
+	printf("spsc_queue M/s, one by one : %.1f, batches of 64 : %.1f%s\n",
+		   single, batched, ok && batched_ok ? "" : " (OUT OF ORDER)");
+	for (int threads = 1; threads != 0 && threads <= 128; threads = next_thread_count(threads))
+	{
+		double rate = mpmc_rate(threads, ok);
+		printf("mpmc_queue M/s, %d producers and %d consumers : %.1f%s\n",
+			   threads, threads, rate, ok ? "" : " (LOST, DUPLICATED OR REORDERED)");
+	}
+}
+
+// work_stealing_deque stress: the owner pushes n tasks and pops every
+// third time, thieves steal until the owner has run dry; every task must
+// have been taken exactly once
+void ws_thief(MySTL::work_stealing_deque<int>* d, std::atomic<bool>* done, MySTL::vector<int>* got)
+{
+	int x;
+	for (;;)
+	{
+		if (d->steal(x))
+			got->push_back(x);
+		else if (done->load(std::memory_order_acquire) && d->empty_approx())
+			break;
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool ws_stress(int n, int thieves)
+{
+	MySTL::work_stealing_deque<int> d(16);
+	std::atomic<bool> done(false);
+	MySTL::vector<int> got[64];
+	std::thread threads[64];
+	for (int t = 1; t <= thieves; ++t)
+		threads[t] = std::thread(ws_thief, &d, &done, &got[t]);
+	int x;
+	for (int i = 0; i < n; ++i)
+	{
+		d.push(i);
+		if (i % 3 == 0 && d.pop(x))
+			got[0].push_back(x);
+	}
+	while (d.pop(x))
+		got[0].push_back(x);
+	done.store(true, std::memory_order_release);
+	for (int t = 1; t <= thieves; ++t)
+		threads[t].join();
+
+	MySTL::vector<int> seen(n, 0);
+	for (int t = 0; t <= thieves; ++t)
+	{
+		for (size_t i = 0; i < got[t].size(); ++i)
+			++seen[got[t][i]];
+	}
+	for (int i = 0; i < n; ++i)
+	{
+		if (seen[i] != 1)
+			return false;
+	}
+	return true;
+}
+
+// thieves emptying a deque of n tasks that the owner filled beforehand,
+// million steals per second
+double ws_steal_rate(int thieves)
+{
+	const int n = 1000000;
+	MySTL::work_stealing_deque<int> d(n);
+	for (int i = 0; i < n; ++i)
+		d.push(i);
+	std::atomic<bool> done(true);
+	MySTL::vector<int> got[64];
+	std::thread threads[64];
+	double start = wall_seconds();
+	for (int t = 0; t < thieves; ++t)
+		threads[t] = std::thread(ws_thief, &d, &done, &got[t]);
+	for (int t = 0; t < thieves; ++t)
+		threads[t].join();
+	return n / (wall_seconds() - start) / 1e6;
+}
+
+void bench_work_stealing()
+{
+	printf("work_stealing_deque, 300000 tasks and 3 thieves : %s\n",
+		   ws_stress(300000, 3) ? "each taken once" : "TASKS LOST OR DUPLICATED");
+	for (int thieves = 1; thieves != 0 && thieves <= 64; thieves = next_thread_count(thieves))
+		printf("work_stealing_deque, %d thieves : %.1f M steals/s\n", thieves, ws_steal_rate(thieves));
+}
+
+// quick_sort_recursive with the right side of every partition of more
+// than 10000 elements spawned as a task
+void parallel_quick_sort(MySTL::thread_pool& pool, int* a, int lo, int hi)
+{
+	MySTL::task_group g(pool);
+	while (hi - lo > 10000)
+	{
+		int mid = MySTL::partition(a, lo, hi);
+		g.spawn([&pool, a, mid, hi] { parallel_quick_sort(pool, a, mid + 1, hi); });
+		hi = mid - 1;
+	}
+	MySTL::quick_sort_recursive(a, lo, hi);
+}
+
+// sorts 4M random ints on a pool of 'threads' workers, 0 for the serial sort
+double time_parallel_quick_sort(int threads, bool& sorted)
+{
+	const int n = 4000000;
+	MySTL::vector<int> a(n);
+	unsigned seed = 1;
+	for (int i = 0; i < n; ++i)
+	{
+		seed = seed * 1103515245u + 12345u;
+		a[i] = (int)(seed >> 1);
+	}
+	double start = wall_seconds();
+	if (threads == 0)
+		MySTL::quick_sort_recursive(&a[0], 0, n - 1);
+	else
+	{
+		MySTL::thread_pool pool(threads);
+		parallel_quick_sort(pool, &a[0], 0, n - 1);
+	}
+	double elapsed = wall_seconds() - start;
+	sorted = true;
+	for (int i = 1; i < n; ++i)
+	{
+		if (a[i - 1] > a[i])
+			sorted = false;
+	}
+	return elapsed;
+}
+
+void bench_thread_pool()
+{
+	bool sorted;
+	printf("quick sort of 4M ints, serial : %.3fs\n", time_parallel_quick_sort(0, sorted));
+	for (int threads = 1; threads != 0; threads = next_thread_count(threads))
+	{
+		double elapsed = time_parallel_quick_sort(threads, sorted);
+		printf("quick sort of 4M ints, thread_pool of %d : %.3fs%s\n",
+			   threads, elapsed, sorted ? "" : " (NOT SORTED)");
+	}
+}
+
+void bench_threaded_allocators()
+{
+	for (int threads = 1; threads != 0 && threads <= 256; threads = next_thread_count(threads))
+	{
+		printf("%d threads alloc/free Mops/s, allocator : %.1f, pool_allocator : %.1f, "
+			   "thread_cache_allocator : %.1f\n", threads,
+			   alloc_free_rate<MySTL::allocator>(threads),
+			   alloc_free_rate<pool_allocator>(threads),
+			   alloc_free_rate<MySTL::thread_cache_allocator>(threads));
+	}
+}
+#endif
 
 
 
@@ -142,7 +888,7 @@ int main(int argc, char* argv[])
 
 	for (int i = 0; i < g.num_vertices(); ++i)
 	{
-		vector<int> path = search.path_to(0, i);
+		Search::Path path = search.path_to(0, i);
 		printf("%d to %d: ", 0, i);
 		for (size_t j = 0; j < path.size(); ++j)
 		{
@@ -172,8 +918,11 @@ int main(int argc, char* argv[])
 	t1.travel(print_node);
 
 	typedef pair<std::string,int> ValueType;
+	typedef type_allocator<MySTL::__hashtable_node<ValueType>,
+						   instrumented_allocator<hashtable_alloc_tag, pool_allocator> >
+					  HashtableAllocator;
 	typedef hashtable<std::string,ValueType,hash<std::string>,
-					  select1st<ValueType>,equal<std::string> > 
+					  select1st<ValueType>,equal<std::string>,HashtableAllocator> 
 					  Hashtable;
 	Hashtable ht(10000);
 
@@ -252,6 +1001,43 @@ int main(int argc, char* argv[])
 		printf("%d : %d\n", (*it).first, (*it).second);
 	}
 
+	// word counting with the chained and the flat hash table
+	MySTL::vector<std::string> words;
+	std::ifstream tale("../data/tale.txt");
+	while (tale >> word)
+		words.push_back(word);
+
+	const int rounds = 20;
+	clock_t start = clock();
+	for (int r = 0; r < rounds; ++r)
+	{
+		typedef hashtable<std::string,ValueType,hash<std::string>,
+						  select1st<ValueType>,equal<std::string> > ChainedTable;
+		ChainedTable chained(10000);
+		for (size_t i = 0; i < words.size(); ++i)
+		{
+			ChainedTable::iterator it = chained.find(words[i]);
+			if (it == chained.end())
+				chained.insert_unique(ValueType(words[i], 1));
+			else
+				++(*it).second;
+		}
+	}
+	clock_t chained_ticks = clock() - start;
+
+	start = clock();
+	size_t flat_unique = 0;
+	for (int r = 0; r < rounds; ++r)
+	{
+		MySTL::hash_map<std::string,int> flat(10000);
+		for (size_t i = 0; i < words.size(); ++i)
+			++flat[words[i]];
+		flat_unique = flat.size();
+	}
+	clock_t flat_ticks = clock() - start;
+	printf("hashtable : %.3fs\n", (double)chained_ticks / CLOCKS_PER_SEC);
+	printf("hash_map : %.3fs, %u unique words\n", (double)flat_ticks / CLOCKS_PER_SEC, (unsigned)flat_unique);
+
 
 // 
 // 	int unique_count = ht.size();
@@ -275,5 +1061,26 @@ int main(int argc, char* argv[])
 
 	printf("%d\n", seq.size(30,50));
 
+	bench_node_allocators();
+	bench_vector_growth();
+	bench_edge_vector();
+	bench_sparse_graph();
+	bench_mapped_vector();
+	bench_hive();
+	bench_queue();
+	bench_bfs_queue();
+	bench_unrolled_list();
+#if defined(__MYSTL_CXX11)
+	bench_vector_move();
+#endif
+#if defined(__MYSTL_CXX11)
+	bench_threaded_allocators();
+	bench_concurrent_queues();
+	bench_work_stealing();
+	bench_thread_pool();
+#endif
+
+	MySTL::print_allocation_report(stdout);
+
 	return 0;
 }
\ No newline at end of file
@@ -4,13 +4,18 @@
 
 __NS_BEGIN
 
-template <class Key, class Value>
-class SeqST : public list<pair<Key,Value> >
+// ordered symbol table on a linear sequence, 'Sequence' may also be an
+// unrolled_list, whose scans touch far fewer nodes
+template <class Key, class Value, class Sequence = list<pair<Key,Value> > >
+class SeqST : public Sequence
 {
 private:
 	typedef pair<Key,Value> ElemType;
 
 public:
+	typedef typename Sequence::iterator iterator;
+	typedef typename Sequence::size_type size_type;
+
 	void put(const Key& key, const Value& value)
 	{
 		iterator p = begin();
@@ -64,21 +69,23 @@ public:
 		}
 		return p;
 	}
+	// the size of the sequence less the keys below 'lo' and above 'hi',
+	// the keys in between are not visited
 	size_type size(const Key& lo, const Key& hi)
 	{
 		if (hi < lo)
 			return 0;
+		size_type outside = 0;
 		iterator left = begin();
 		while (left != end() && (*left).first < lo)
+		{
 			++left;
-		if (left == end())
-			return 0;
-		iterator right = --end();
-		while (right != end() && hi < (*right).first)
-			--right;
-		if (right == end())
-			return 0;
-		return distance(left, right) + 1;
+			++outside;
+		}
+		iterator right = end();
+		while (right != left && hi < (*--right).first)
+			++outside;
+		return Sequence::size() - outside;
 	}
 };
 
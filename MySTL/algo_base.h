@@ -4,6 +4,10 @@
 #include "iterator_base.h"
 #include "string.h"
 
+#if defined(__MYSTL_CXX11)
+#include <type_traits>
+#endif
+
 __NS_BEGIN
 
 template <class T>
@@ -18,12 +22,54 @@ const T& min(const T& a, const T& b)
 	return  a < b ? a : b;
 }
 
+#if defined(__MYSTL_CXX11)
+template <class T>
+typename std::remove_reference<T>::type&& move(T&& x)
+{
+	return static_cast<typename std::remove_reference<T>::type&&>(x);
+}
+
+template <class T>
+T&& forward(typename std::remove_reference<T>::type& x)
+{
+	return static_cast<T&&>(x);
+}
+
+template <class T>
+T&& forward(typename std::remove_reference<T>::type&& x)
+{
+	return static_cast<T&&>(x);
+}
+
+// moves unless the move constructor may throw and a copy is possible, so a
+// failed relocation leaves the source untouched
+template <class T>
+typename std::conditional<!std::is_nothrow_move_constructible<T>::value && std::is_copy_constructible<T>::value,
+	const T&, T&&>::type move_if_noexcept(T& x)
+{
+	return MySTL::move(x);
+}
+#else
+// without rvalue references moving is copying
+template <class T>
+T& move(T& x)
+{
+	return x;
+}
+
+template <class T>
+T& move_if_noexcept(T& x)
+{
+	return x;
+}
+#endif
+
 template <class T>
 void swap(T& a, T& b)
 {
-	T tmp = a;
-	a = b;
-	b = tmp;
+	T tmp = MySTL::move(a);
+	a = MySTL::move(b);
+	b = MySTL::move(tmp);
 }
 
 template <class T>
@@ -90,11 +136,73 @@ T* copy_aux(T* first, T* last, T* result, true_type)
 };
 
 template <class ForwardIterator, class InputIterator>
-ForwardIterator copy(InputIterator first, InputIterator last, ForwardIterator result)
+ForwardIterator copy(InputIterator first, InputIterator last, ForwardIterator result);
+
+template <class ForwardIterator, class InputIterator>
+ForwardIterator __copy_segmented(InputIterator first, InputIterator last, ForwardIterator result,
+								 false_type, false_type)
 {
 	typedef typename iterator_traits<ForwardIterator>::value_type value_type;
 	typedef typename type_traits<value_type>::has_trivial_assignment_operator has_trivial_assignment_operator;
 	return copy_aux(first, last, result, has_trivial_assignment_operator());
+}
+
+// a segmented source is copied one segment at a time from local iterators
+template <class ForwardIterator, class SegmentedIterator, class OutSegmented>
+ForwardIterator __copy_segmented(SegmentedIterator first, SegmentedIterator last, ForwardIterator result,
+								 true_type, OutSegmented)
+{
+	typedef segmented_iterator_traits<SegmentedIterator> Traits;
+	typename Traits::segment_iterator sfirst = Traits::segment(first);
+	typename Traits::segment_iterator slast = Traits::segment(last);
+	if (sfirst == slast)
+		return MySTL::copy(Traits::local(first), Traits::local(last), result);
+	result = MySTL::copy(Traits::local(first), Traits::end(sfirst), result);
+	for (++sfirst; sfirst != slast; ++sfirst)
+		result = MySTL::copy(Traits::begin(sfirst), Traits::end(sfirst), result);
+	return MySTL::copy(Traits::begin(slast), Traits::local(last), result);
+}
+
+template <class SegmentedIterator, class InputIterator>
+SegmentedIterator __copy_to_segmented(InputIterator first, InputIterator last, SegmentedIterator result,
+									  input_iterator_tag)
+{
+	return __copy_segmented(first, last, result, false_type(), false_type());
+}
+
+// a random access source is cut to fit the segments of the destination
+template <class SegmentedIterator, class RandomAccessIterator>
+SegmentedIterator __copy_to_segmented(RandomAccessIterator first, RandomAccessIterator last,
+									  SegmentedIterator result, random_access_iterator_tag)
+{
+	typedef segmented_iterator_traits<SegmentedIterator> Traits;
+	typedef typename iterator_traits<RandomAccessIterator>::difference_type Distance;
+	Distance n = last - first;
+	while (n > 0)
+	{
+		typename Traits::local_iterator cur = Traits::local(result);
+		Distance len = MySTL::min(n, Distance(Traits::end(Traits::segment(result)) - cur));
+		MySTL::copy(first, first + len, cur);
+		first += len;
+		result += len;
+		n -= len;
+	}
+	return result;
+}
+
+template <class SegmentedIterator, class InputIterator>
+SegmentedIterator __copy_segmented(InputIterator first, InputIterator last, SegmentedIterator result,
+								   false_type, true_type)
+{
+	return __copy_to_segmented(first, last, result, iterator_category(first));
+}
+
+template <class ForwardIterator, class InputIterator>
+ForwardIterator copy(InputIterator first, InputIterator last, ForwardIterator result)
+{
+	typedef typename segmented_iterator_traits<InputIterator>::is_segmented in_segmented;
+	typedef typename segmented_iterator_traits<ForwardIterator>::is_segmented out_segmented;
+	return __copy_segmented(first, last, result, in_segmented(), out_segmented());
 };
 
 template <class BI1, class BI2, class DiffType>
@@ -162,13 +270,85 @@ BI1 copy_backward(BI2 first, BI2 last, BI1 result)
 	return copy_backward_aux(first, last, result, has_trivial_assignment_operator());
 }
 
+template <class ForwardIterator, class InputIterator>
+ForwardIterator move_aux(InputIterator first, InputIterator last, ForwardIterator result, false_type)
+{
+	for ( ; first != last; ++first, ++result)
+		*result = MySTL::move(*first);
+	return result;
+}
+
+template <class ForwardIterator, class InputIterator>
+ForwardIterator move_aux(InputIterator first, InputIterator last, ForwardIterator result, true_type)
+{
+	return MySTL::copy(first, last, result);
+}
+
+// like copy, but the source elements are left moved-from
+template <class ForwardIterator, class InputIterator>
+ForwardIterator move(InputIterator first, InputIterator last, ForwardIterator result)
+{
+	typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+	typedef typename type_traits<value_type>::has_trivial_assignment_operator has_trivial_assignment_operator;
+	return move_aux(first, last, result, has_trivial_assignment_operator());
+}
+
+template <class BI1, class BI2>
+BI1 move_backward_aux(BI2 first, BI2 last, BI1 result, false_type)
+{
+	while (last != first)
+		*--result = MySTL::move(*--last);
+	return result;
+}
+
+template <class BI1, class BI2>
+BI1 move_backward_aux(BI2 first, BI2 last, BI1 result, true_type)
+{
+	return MySTL::copy_backward(first, last, result);
+}
+
+template <class BI1, class BI2>
+BI1 move_backward(BI2 first, BI2 last, BI1 result)
+{
+	typedef typename iterator_traits<BI1>::value_type value_type;
+	typedef typename type_traits<value_type>::has_trivial_assignment_operator has_trivial_assignment_operator;
+	return move_backward_aux(first, last, result, has_trivial_assignment_operator());
+}
+
 template <class ForwardIterator, class Tp>
-void fill(ForwardIterator first, ForwardIterator last, const Tp& val)
+void fill(ForwardIterator first, ForwardIterator last, const Tp& val);
+
+template <class ForwardIterator, class Tp>
+void __fill_segmented(ForwardIterator first, ForwardIterator last, const Tp& val, false_type)
 {
 	for ( ; first != last; ++first)
 		*first = val;
 }
 
+template <class SegmentedIterator, class Tp>
+void __fill_segmented(SegmentedIterator first, SegmentedIterator last, const Tp& val, true_type)
+{
+	typedef segmented_iterator_traits<SegmentedIterator> Traits;
+	typename Traits::segment_iterator sfirst = Traits::segment(first);
+	typename Traits::segment_iterator slast = Traits::segment(last);
+	if (sfirst == slast)
+	{
+		MySTL::fill(Traits::local(first), Traits::local(last), val);
+		return;
+	}
+	MySTL::fill(Traits::local(first), Traits::end(sfirst), val);
+	for (++sfirst; sfirst != slast; ++sfirst)
+		MySTL::fill(Traits::begin(sfirst), Traits::end(sfirst), val);
+	MySTL::fill(Traits::begin(slast), Traits::local(last), val);
+}
+
+template <class ForwardIterator, class Tp>
+void fill(ForwardIterator first, ForwardIterator last, const Tp& val)
+{
+	typedef typename segmented_iterator_traits<ForwardIterator>::is_segmented segmented;
+	__fill_segmented(first, last, val, segmented());
+}
+
 template <class ForwardIterator, class Tp, class Size>
 ForwardIterator fill_n(ForwardIterator result, Size n, const Tp& val)
 {
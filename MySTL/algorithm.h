@@ -7,14 +7,14 @@ __NS_BEGIN
 template <class ForwardIter, class Tp, class Distance>
 ForwardIter __lower_bound(ForwardIter first, ForwardIter last, const Tp& val, Distance*) 
 {
-	Distance len = distance(first, last);
+	Distance len = MySTL::distance(first, last);
 	Distance half;
 	ForwardIter middle;
 	while (len > 0)
 	{
 		half = len >> 1;
 		middle = first;
-		advance(middle, half);
+		MySTL::advance(middle, half);
 		if (*middle < val) 
 		{
 			first = middle;
@@ -27,18 +27,16 @@ ForwardIter __lower_bound(ForwardIter first, ForwardIter last, const Tp& val, Di
 	return first;
 }
 
-template <class ForwardIter, class Tp>
-inline ForwardIter lower_bound(ForwardIter first, ForwardIter last, const Tp& val) 
-{
-	return __lower_bound(first, last, val, distance_type(first));
-}
+template <class ForwardIter, class Tp, class Cmp>
+ForwardIter lower_bound(ForwardIter first, ForwardIter last, const Tp& val, Cmp cmp);
+
 
 template <class ForwardIter, class Tp, class Cmp, class Distance>
 ForwardIter __lower_bound(ForwardIter first, ForwardIter last,
 						   const Tp& val, Cmp cmp, Distance*)
 {
 	Distance len = 0;
-	distance(first, last, len);
+	MySTL::distance(first, last, len);
 	Distance half;
 	ForwardIter middle;
 
@@ -46,7 +44,7 @@ ForwardIter __lower_bound(ForwardIter first, ForwardIter last,
 	{
 		half = len >> 1;
 		middle = first;
-		advance(middle, half);
+		MySTL::advance(middle, half);
 		if (cmp(*middle, val)) 
 		{
 			first = middle;
@@ -60,11 +58,109 @@ ForwardIter __lower_bound(ForwardIter first, ForwardIter last,
 }
 
 template <class ForwardIter, class Tp, class Cmp>
-inline ForwardIter lower_bound(ForwardIter first, ForwardIter last, const Tp& val, Cmp cmp) 
+inline ForwardIter __lower_bound_segmented(ForwardIter first, ForwardIter last, const Tp& val, Cmp cmp, false_type)
 {
 	return __lower_bound(first, last, val, cmp, distance_type(first));
 }
 
+// Finds the segment first, by the last element of each, then searches
+// inside it; the segments must be random access.
+template <class SegmentedIter, class Tp, class Cmp>
+SegmentedIter __lower_bound_segmented(SegmentedIter first, SegmentedIter last, const Tp& val, Cmp cmp, true_type)
+{
+	typedef segmented_iterator_traits<SegmentedIter> Traits;
+	typedef typename Traits::segment_iterator segment_iterator;
+	segment_iterator sfirst = Traits::segment(first);
+	segment_iterator slast = Traits::segment(last);
+	if (sfirst == slast)
+		return Traits::compose(sfirst, MySTL::lower_bound(Traits::local(first), Traits::local(last), val, cmp));
+	if (!cmp(*(Traits::end(sfirst) - 1), val))
+		return Traits::compose(sfirst, MySTL::lower_bound(Traits::local(first), Traits::end(sfirst), val, cmp));
+
+	segment_iterator seg = sfirst + 1;
+	ptrdiff_t len = slast - seg;
+	while (len > 0)
+	{
+		ptrdiff_t half = len >> 1;
+		segment_iterator middle = seg + half;
+		if (cmp(*(Traits::end(middle) - 1), val))
+		{
+			seg = middle + 1;
+			len = len - half - 1;
+		}
+		else
+			len = half;
+	}
+	if (seg != slast)
+		return Traits::compose(seg, MySTL::lower_bound(Traits::begin(seg), Traits::end(seg), val, cmp));
+	return Traits::compose(slast, MySTL::lower_bound(Traits::begin(slast), Traits::local(last), val, cmp));
+}
+
+template <class ForwardIter, class Tp, class Cmp>
+inline ForwardIter lower_bound(ForwardIter first, ForwardIter last, const Tp& val, Cmp cmp) 
+{
+	typedef typename segmented_iterator_traits<ForwardIter>::is_segmented segmented;
+	return __lower_bound_segmented(first, last, val, cmp, segmented());
+}
+
+struct __lower_bound_less
+{
+	template <class T1, class T2>
+	bool operator()(const T1& x, const T2& y) const { return x < y; }
+};
+
+template <class ForwardIter, class Tp>
+inline ForwardIter __lower_bound_segmented(ForwardIter first, ForwardIter last, const Tp& val, false_type)
+{
+	return __lower_bound(first, last, val, distance_type(first));
+}
+
+template <class SegmentedIter, class Tp>
+inline SegmentedIter __lower_bound_segmented(SegmentedIter first, SegmentedIter last, const Tp& val, true_type)
+{
+	return __lower_bound_segmented(first, last, val, __lower_bound_less(), true_type());
+}
+
+template <class ForwardIter, class Tp>
+inline ForwardIter lower_bound(ForwardIter first, ForwardIter last, const Tp& val) 
+{
+	typedef typename segmented_iterator_traits<ForwardIter>::is_segmented segmented;
+	return __lower_bound_segmented(first, last, val, segmented());
+}
+
+template <class InputIterator, class Function>
+Function for_each(InputIterator first, InputIterator last, Function f);
+
+template <class InputIterator, class Function>
+Function __for_each_segmented(InputIterator first, InputIterator last, Function f, false_type)
+{
+	for ( ; first != last; ++first)
+		f(*first);
+	return f;
+}
+
+template <class SegmentedIterator, class Function>
+Function __for_each_segmented(SegmentedIterator first, SegmentedIterator last, Function f, true_type)
+{
+	typedef segmented_iterator_traits<SegmentedIterator> Traits;
+	typename Traits::segment_iterator sfirst = Traits::segment(first);
+	typename Traits::segment_iterator slast = Traits::segment(last);
+	if (sfirst == slast)
+		return MySTL::for_each(Traits::local(first), Traits::local(last), f);
+	f = MySTL::for_each(Traits::local(first), Traits::end(sfirst), f);
+	for (++sfirst; sfirst != slast; ++sfirst)
+		f = MySTL::for_each(Traits::begin(sfirst), Traits::end(sfirst), f);
+	return MySTL::for_each(Traits::begin(slast), Traits::local(last), f);
+}
+
+// applies 'f' to every element, segmented ranges segment by segment
+template <class InputIterator, class Function>
+Function for_each(InputIterator first, InputIterator last, Function f)
+{
+	typedef typename segmented_iterator_traits<InputIterator>::is_segmented segmented;
+	return __for_each_segmented(first, last, f, segmented());
+}
+
 template <class RAI, class Tp>
 void unguarded_linear_insert(RAI last, Tp value)
 {
@@ -1,51 +1,337 @@
 #pragma once
 
+#include <stdlib.h>
+#include <string.h>
+#include <new>
 #include "config.h"
+#include "type_traits.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <malloc.h>
+#include <sys/mman.h>
+#endif
 
 __NS_BEGIN
 
+enum { __MALLOC_ALIGN = 2 * sizeof(void*) };
+enum { __CACHE_LINE_SIZE = 64 };
+enum { __CACHE_ALIGN_THRESHOLD = 1024 };
+enum { __HUGE_PAGE_SIZE = 2 * 1024 * 1024 };
+
+// allocate_chain(n, count) returns 'count' blocks of 'n' bytes, n being at
+// least a pointer, linked through their first word; each block is freed on
+// its own later. Allocators that cannot carve the blocks from one chunk
+// build the chain with one allocate() per block.
+inline void* __chain_next(void* p) { return *(void**)p; }
+
+template <class Alloc>
+void* __allocate_chain_each(size_t n, size_t count)
+{
+	void* head = 0;
+	for ( ; count > 0; --count)
+	{
+		void* p = Alloc::allocate(n);
+		*(void**)p = head;
+		head = p;
+	}
+	return head;
+}
+
+// Blocks of __CACHE_ALIGN_THRESHOLD bytes or more start on a cache line,
+// smaller ones get the usual malloc alignment. Every block is released the
+// same way, so deallocate() does not need the size or the alignment.
+//
+// Huge pages are opt-in: after set_huge_page_threshold(n), blocks of at
+// least n bytes are aligned to __HUGE_PAGE_SIZE and marked for transparent
+// huge pages with madvise (Linux only, elsewhere they are just cache line
+// aligned).
+//
+// reallocate() and try_expand_in_place() let callers with bitwise movable
+// contents grow a block without copying it themselves: the first goes
+// through realloc (mremap for large blocks on Linux), the second succeeds
+// when the block already has room for the new size. realloc only keeps the
+// malloc alignment, so a grown block gives up the cache line alignment
+// unless the caller asks for it, and blocks that must stay over-aligned
+// are copied to a new block once instead of through realloc. With MSVC,
+// _aligned_realloc cannot change the alignment of a block, so a block
+// whose alignment changes with its new size is copied as well.
 class allocator
 {
 public:
 	static void* allocate(size_t n)
 	{
-		return n == 0? 0 : ::operator new(n);
+		if (n == 0)
+			return 0;
+		return allocate(n, __default_align(n));
+	}
+
+	static void* allocate(size_t n, size_t align)
+	{
+		if (n == 0)
+			return 0;
+		size_t huge_threshold = __huge_page_threshold();
+		if (huge_threshold != 0 && n >= huge_threshold)
+			return __allocate_huge(n);
+		return __aligned_malloc(n, align);
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n)
+	{
+#if defined(_MSC_VER)
+		// a block from allocate(n) has the default alignment of its size
+		if (p != 0 && new_n != 0 && __default_align(old_n) != __default_align(new_n))
+			return __reallocate_by_copy(p, old_n, new_n, __default_align(new_n));
+		return reallocate(p, old_n, new_n, __default_align(old_n));
+#else
+		return reallocate(p, old_n, new_n, (size_t)__MALLOC_ALIGN);
+#endif
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n, size_t align)
+	{
+		if (p == 0)
+			return allocate(new_n, align);
+		if (new_n == 0)
+		{
+			__aligned_free(p);
+			return 0;
+		}
+		size_t huge_threshold = __huge_page_threshold();
+		bool huge = huge_threshold != 0 && new_n >= huge_threshold;
+#if defined(_MSC_VER)
+		// _aligned_realloc must be given the alignment the block was made
+		// with, a block that changes alignment is copied
+		size_t old_align = huge_threshold != 0 && old_n >= huge_threshold ? __huge_align() : align;
+		if (huge)
+			align = __huge_align();
+		if (old_align != align)
+			return __reallocate_by_copy(p, old_n, new_n, align);
+		void* q = _aligned_realloc(p, new_n, align < (size_t)__MALLOC_ALIGN ? (size_t)__MALLOC_ALIGN : align);
+		if (q == 0)
+			throw std::bad_alloc();
+#else
+		if (huge)
+			align = __huge_align();
+		if (align > (size_t)__MALLOC_ALIGN)
+			return __reallocate_by_copy(p, old_n, new_n, align);
+		void* q = realloc(p, new_n);
+		if (q == 0)
+			throw std::bad_alloc();
+#endif
+		if (huge)
+			__advise_huge(q, new_n);
+		return q;
+	}
+
+	// malloc blocks cannot be freed piecewise, so one allocation per block
+	static void* allocate_chain(size_t n, size_t count) { return __allocate_chain_each<allocator>(n, count); }
+
+	static bool try_expand_in_place(void* p, size_t, size_t new_n)
+	{
+#if defined(__GLIBC__)
+		return p != 0 && malloc_usable_size(p) >= new_n;
+#else
+		return false;
+#endif
 	}
 
 	static void deallocate(void* p)
 	{
-		::operator delete(p);
+		__aligned_free(p);
 	}
 
 	static void deallocate(void* p, size_t)
 	{
-		::operator delete(p);
+		__aligned_free(p);
+	}
+
+	static void deallocate(void* p, size_t, size_t)
+	{
+		__aligned_free(p);
+	}
+
+	// 0 turns the huge page path off (the default)
+	static void set_huge_page_threshold(size_t threshold) { __huge_page_threshold() = threshold; }
+	static size_t huge_page_threshold() { return __huge_page_threshold(); }
+
+private:
+	static size_t& __huge_page_threshold()
+	{
+		static size_t threshold = 0;
+		return threshold;
+	}
+
+	static size_t __default_align(size_t n)
+	{
+		return n >= (size_t)__CACHE_ALIGN_THRESHOLD ? 
+			(size_t)__CACHE_LINE_SIZE : (size_t)__MALLOC_ALIGN;
+	}
+
+	static void* __aligned_malloc(size_t n, size_t align)
+	{
+		void* p;
+#if defined(_MSC_VER)
+		p = _aligned_malloc(n, align < (size_t)__MALLOC_ALIGN ? (size_t)__MALLOC_ALIGN : align);
+#else
+		if (align <= (size_t)__MALLOC_ALIGN)
+			p = malloc(n);
+		else if (posix_memalign(&p, align, n) != 0)
+			p = 0;
+#endif
+		if (p == 0)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	static void* __reallocate_by_copy(void* p, size_t old_n, size_t new_n, size_t align)
+	{
+		void* r = allocate(new_n, align);
+		memcpy(r, p, old_n < new_n ? old_n : new_n);
+		__aligned_free(p);
+		return r;
+	}
+
+	static void __aligned_free(void* p)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+
+	static size_t __huge_align()
+	{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		return __HUGE_PAGE_SIZE;
+#else
+		return __CACHE_LINE_SIZE;
+#endif
+	}
+
+	static void __advise_huge(void* p, size_t n)
+	{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		size_t huge_bytes = n & ~(size_t(__HUGE_PAGE_SIZE) - 1);
+		if (huge_bytes != 0)
+			madvise(p, huge_bytes, MADV_HUGEPAGE);
+#else
+		(void)p;
+		(void)n;
+#endif
+	}
+
+	static void* __allocate_huge(size_t n)
+	{
+		void* p = __aligned_malloc(n, __huge_align());
+		__advise_huge(p, n);
+		return p;
 	}
 };
 
+// A container's allocator stored with one of its members. The allocator is
+// an empty base here, so a stateless one adds nothing to the container.
+template <class Alloc, class T>
+struct __alloc_pair : public Alloc
+{
+	T m_value;
+
+	__alloc_pair() : m_value() {}
+	__alloc_pair(const Alloc& a, const T& value) : Alloc(a), m_value(value) {}
+
+	Alloc& __alloc() { return *this; }
+	const Alloc& __alloc() const { return *this; }
+};
+
+// true_type when T needs more alignment than malloc guarantees
+template <class T>
+struct __over_aligned
+{
+	typedef typename __bool_type<(__MYSTL_ALIGNOF(T) > (size_t)__MALLOC_ALIGN)>::type type;
+};
+
 
 template <class T, class Alloc = allocator>
 class type_allocator
 {
 public:
+	typedef T value_type;
+
+	template <class U>
+	struct rebind
+	{
+		typedef type_allocator<U, Alloc> other;
+	};
+
+	type_allocator() {}
+	template <class U>
+	type_allocator(const type_allocator<U, Alloc>&) {}
+
 	static T* allocate(void)
 	{
-		return (T*)Alloc::allocate(sizeof(T));
+		return (T*)__allocate(sizeof(T), typename __over_aligned<T>::type());
 	}
 	
 	static T* allocate(size_t n)
 	{
-		return n == 0? 0 : (T*)Alloc::allocate(n * sizeof(T));
+		return n == 0? 0 : (T*)__allocate(n * sizeof(T), typename __over_aligned<T>::type());
+	}
+
+	// 'n' objects linked through their first word, each one freed with
+	// deallocate(p) later; T must be at least as large as a pointer
+	static T* allocate_chain(size_t n)
+	{
+		return (T*)__allocate_chain(n, typename __over_aligned<T>::type());
 	}
 
 	static void deallocate(T* p)
 	{
-		Alloc::deallocate(p);
+		__deallocate(p, sizeof(T), typename __over_aligned<T>::type());
 	}
 
-	static void deallocate(T* p, size_t)
+	static void deallocate(T* p, size_t n)
+	{
+		__deallocate(p, n * sizeof(T), typename __over_aligned<T>::type());
+	}
+
+	// the contents are moved bitwise, only for trivially relocatable T
+	static T* reallocate(T* p, size_t old_n, size_t new_n)
+	{
+		return (T*)__reallocate(p, old_n * sizeof(T), new_n * sizeof(T), typename __over_aligned<T>::type());
+	}
+
+	static bool try_expand_in_place(T* p, size_t old_n, size_t new_n)
+	{
+		return Alloc::try_expand_in_place(p, old_n * sizeof(T), new_n * sizeof(T));
+	}
+
+private:
+	// only over-aligned types need an Alloc with the aligned overloads
+	static void* __allocate(size_t bytes, false_type) { return Alloc::allocate(bytes); }
+	static void* __allocate(size_t bytes, true_type) { return Alloc::allocate(bytes, __MYSTL_ALIGNOF(T)); }
+	static void* __allocate_chain(size_t n, false_type) { return Alloc::allocate_chain(sizeof(T), n); }
+	static void* __allocate_chain(size_t n, true_type)
+	{
+		void* head = 0;
+		for ( ; n > 0; --n)
+		{
+			void* p = __allocate(sizeof(T), true_type());
+			*(void**)p = head;
+			head = p;
+		}
+		return head;
+	}
+	static void __deallocate(T* p, size_t bytes, false_type) { Alloc::deallocate(p, bytes); }
+	static void __deallocate(T* p, size_t bytes, true_type) { Alloc::deallocate(p, bytes, __MYSTL_ALIGNOF(T)); }
+	static void* __reallocate(T* p, size_t old_bytes, size_t new_bytes, false_type)
+	{
+		return Alloc::reallocate(p, old_bytes, new_bytes);
+	}
+	static void* __reallocate(T* p, size_t old_bytes, size_t new_bytes, true_type)
 	{
-		Alloc::deallocate(p);
+		return Alloc::reallocate(p, old_bytes, new_bytes, __MYSTL_ALIGNOF(T));
 	}
 };
 
@@ -4,6 +4,7 @@
 #include "type_traits.h"
 #include "iterator_base.h"
 #include "algo_base.h"
+#include "pool_allocator.h"
 #include "stack.h"
 
 #include <string>
@@ -122,7 +123,7 @@ void __right_rotate(__AVL_tree_node<Tp>*& x)
 
 template <class Key, class Value, 
           class ExtractKey, class KeyCompare,
-		  class Alloc = type_allocator<__AVL_tree_node<Value> > >
+		  class Alloc = type_allocator<__AVL_tree_node<Value>, pool_allocator> >
 class AVL_tree
 {
 public:
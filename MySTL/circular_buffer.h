@@ -0,0 +1,354 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+#include "type_traits.h"
+
+__NS_BEGIN
+
+// 'm_pos' counts from the start of the buffer without wrapping, only the
+// access is masked, so the iterator arithmetic is plain integer arithmetic
+template <class T, class Ref, class Ptr>
+struct __circular_buffer_iterator
+{
+	typedef random_access_iterator_tag category;
+	typedef T value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef __circular_buffer_iterator Self;
+	typedef __circular_buffer_iterator<T, T&, T*> iterator;
+
+	T* m_buf;
+	size_type m_mask;
+	size_type m_pos;
+
+	__circular_buffer_iterator() : m_buf(0), m_mask(0), m_pos(0) {}
+	__circular_buffer_iterator(T* buf, size_type mask, size_type pos)
+		: m_buf(buf), m_mask(mask), m_pos(pos) {}
+	__circular_buffer_iterator(const iterator& x)
+		: m_buf(x.m_buf), m_mask(x.m_mask), m_pos(x.m_pos) {}
+
+	reference operator*() const { return m_buf[m_pos & m_mask]; }
+	pointer operator->() const { return &**this; }
+	reference operator[](difference_type n) const { return m_buf[(m_pos + n) & m_mask]; }
+
+	Self& operator++() { ++m_pos; return *this; }
+	Self operator++(int) { Self tmp = *this; ++m_pos; return tmp; }
+	Self& operator--() { --m_pos; return *this; }
+	Self operator--(int) { Self tmp = *this; --m_pos; return tmp; }
+	Self& operator+=(difference_type n) { m_pos += n; return *this; }
+	Self& operator-=(difference_type n) { m_pos -= n; return *this; }
+	Self operator+(difference_type n) const { return Self(m_buf, m_mask, m_pos + n); }
+	Self operator-(difference_type n) const { return Self(m_buf, m_mask, m_pos - n); }
+	difference_type operator-(const Self& x) const { return difference_type(m_pos - x.m_pos); }
+
+	bool operator==(const Self& x) const { return m_pos == x.m_pos; }
+	bool operator!=(const Self& x) const { return m_pos != x.m_pos; }
+	bool operator<(const Self& x) const { return m_pos < x.m_pos; }
+	bool operator>(const Self& x) const { return x < *this; }
+	bool operator<=(const Self& x) const { return !(x < *this); }
+	bool operator>=(const Self& x) const { return !(*this < x); }
+};
+
+template <class T, class Ref, class Ptr>
+__circular_buffer_iterator<T, Ref, Ptr> operator+(ptrdiff_t n, const __circular_buffer_iterator<T, Ref, Ptr>& x)
+{
+	return x + n;
+}
+
+// double ended queue in one contiguous block whose size is a power of two,
+// an index wraps around with a mask. It fits queue<> and stack<> as the
+// Sequence. Default constructed it doubles when full. Constructed with a
+// capacity it never reallocates, pushing onto a full buffer then throws
+// bad_alloc like inplace_vector, try_push_back reports it instead.
+template <class T, class Alloc = type_allocator<T> >
+class circular_buffer
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef __circular_buffer_iterator<T, T&, T*> iterator;
+	typedef __circular_buffer_iterator<T, const T&, const T*> const_iterator;
+	typedef Alloc allocator_type;
+
+private:
+	enum { __initial_capacity = 16 };
+
+	T* m_start;
+	size_type m_mask;		// allocated slots - 1, 0 while nothing is allocated
+	size_type m_head;
+	size_type m_size;
+	size_type m_max;		// the fixed capacity, 0 when growable
+	Alloc m_alloc;
+
+	size_type __slots() const { return m_start ? m_mask + 1 : 0; }
+	T* __slot(size_type i) const { return m_start + ((m_head + i) & m_mask); }
+
+	static size_type __round_up(size_type n)
+	{
+		size_type slots = 1;
+		while (slots < n)
+			slots <<= 1;
+		return slots;
+	}
+
+	static void __move_elements(T* first, T* last, T* result, true_type)
+	{
+		memcpy((void*)result, (void*)first, (last - first) * sizeof(T));
+	}
+	static void __move_elements(T* first, T* last, T* result, false_type)
+	{
+		range_move_construct(first, last, result);
+		range_destruct(first, last);
+	}
+
+	// moves the elements to a new block of 'slots' slots, the front to slot 0
+	void __reallocate(size_type slots)
+	{
+		typedef typename is_trivially_relocatable<T>::type relocatable;
+		T* new_start = m_alloc.allocate(slots);
+		if (m_size != 0)
+		{
+			size_type first_len = MySTL::min(m_size, m_mask + 1 - m_head);
+			__move_elements(m_start + m_head, m_start + m_head + first_len, new_start, relocatable());
+			__move_elements(m_start, m_start + (m_size - first_len), new_start + first_len, relocatable());
+		}
+		if (m_start)
+			m_alloc.deallocate(m_start, m_mask + 1);
+		m_start = new_start;
+		m_mask = slots - 1;
+		m_head = 0;
+	}
+
+	void __make_room()
+	{
+		if (full())
+			throw std::bad_alloc();
+		if (m_size != __slots())
+			return;
+		__reallocate(m_start ? 2 * (m_mask + 1) : size_type(__initial_capacity));
+	}
+
+	void __initialize(size_type max_n)
+	{
+		m_start = 0;
+		m_mask = 0;
+		m_head = 0;
+		m_size = 0;
+		m_max = max_n;
+		if (max_n != 0)
+			__reallocate(__round_up(max_n));
+	}
+
+	template <class InputIterator>
+	void __range_initialize(InputIterator first, InputIterator last, false_type)
+	{
+		for ( ; first != last; ++first)
+			push_back(*first);
+	}
+	template <class Integer>
+	void __range_initialize(Integer n, Integer x, true_type)
+	{
+		reserve(n);
+		for ( ; n > 0; --n)
+			push_back(x);
+	}
+
+public:
+	circular_buffer() { __initialize(0); }
+	explicit circular_buffer(const Alloc& a) : m_alloc(a) { __initialize(0); }
+	// fixed capacity mode, at most 'max_n' elements, max_n > 0
+	explicit circular_buffer(size_type max_n, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__initialize(max_n);
+	}
+	template <class InputIterator>
+	circular_buffer(InputIterator first, InputIterator last, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__initialize(0);
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__range_initialize(first, last, is_int());
+	}
+	circular_buffer(const circular_buffer<T, Alloc>& other)
+		: m_alloc(other.m_alloc)
+	{
+		__initialize(other.m_max);
+		reserve(other.size());
+		for (const_iterator i = other.begin(); i != other.end(); ++i)
+			push_back(*i);
+	}
+#if defined(__MYSTL_CXX11)
+	circular_buffer(circular_buffer<T, Alloc>&& other)
+		: m_alloc(other.m_alloc)
+	{
+		__initialize(0);
+		swap(other);
+	}
+#endif
+
+	~circular_buffer()
+	{
+		clear();
+		if (m_start)
+			m_alloc.deallocate(m_start, m_mask + 1);
+	}
+
+	iterator begin() { return iterator(m_start, m_mask, m_head); }
+	const_iterator begin() const { return const_iterator(m_start, m_mask, m_head); }
+	iterator end() { return iterator(m_start, m_mask, m_head + m_size); }
+	const_iterator end() const { return const_iterator(m_start, m_mask, m_head + m_size); }
+
+	size_type size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	bool full() const { return m_max != 0 && m_size == m_max; }
+	size_type capacity() const { return m_max != 0 ? m_max : __slots(); }
+	bool is_fixed_capacity() const { return m_max != 0; }
+	allocator_type get_allocator() const { return m_alloc; }
+
+	reference front() { return m_start[m_head]; }
+	const_reference front() const { return m_start[m_head]; }
+	reference back() { return *__slot(m_size - 1); }
+	const_reference back() const { return *__slot(m_size - 1); }
+	reference operator[](size_type n) { return *__slot(n); }
+	const_reference operator[](size_type n) const { return *__slot(n); }
+
+	void push_back(const T& x)
+	{
+		if (m_size == __slots() || full())
+		{
+			T x_copy = x;
+			__make_room();
+			construct(__slot(m_size), MySTL::move(x_copy));
+		}
+		else
+			construct(__slot(m_size), x);
+		++m_size;
+	}
+	void push_front(const T& x)
+	{
+		if (m_size == __slots() || full())
+		{
+			T x_copy = x;
+			__make_room();
+			construct(m_start + ((m_head - 1) & m_mask), MySTL::move(x_copy));
+		}
+		else
+			construct(m_start + ((m_head - 1) & m_mask), x);
+		m_head = (m_head - 1) & m_mask;
+		++m_size;
+	}
+	// false and no change when a fixed capacity buffer is full
+	bool try_push_back(const T& x)
+	{
+		if (full())
+			return false;
+		push_back(x);
+		return true;
+	}
+#if defined(__MYSTL_CXX11)
+	void push_back(T&& x) { emplace_back(MySTL::move(x)); }
+	void push_front(T&& x) { emplace_front(MySTL::move(x)); }
+	template <class... Args>
+	void emplace_back(Args&&... args)
+	{
+		if (m_size == __slots() || full())
+		{
+			T x(MySTL::forward<Args>(args)...);
+			__make_room();
+			construct(__slot(m_size), MySTL::move(x));
+		}
+		else
+			construct(__slot(m_size), MySTL::forward<Args>(args)...);
+		++m_size;
+	}
+	template <class... Args>
+	void emplace_front(Args&&... args)
+	{
+		T x(MySTL::forward<Args>(args)...);
+		__make_room();
+		construct(m_start + ((m_head - 1) & m_mask), MySTL::move(x));
+		m_head = (m_head - 1) & m_mask;
+		++m_size;
+	}
+#endif
+
+	void pop_front()
+	{
+		destruct(m_start + m_head);
+		m_head = (m_head + 1) & m_mask;
+		--m_size;
+	}
+	void pop_back()
+	{
+		--m_size;
+		destruct(__slot(m_size));
+	}
+	void clear()
+	{
+		range_destruct(begin(), end());
+		m_head = 0;
+		m_size = 0;
+	}
+
+	// a growable buffer takes room for 'n' elements at once, a fixed one
+	// only checks that they fit
+	void reserve(size_type n)
+	{
+		if (m_max != 0)
+		{
+			if (n > m_max)
+				throw std::bad_alloc();
+		}
+		else if (n > __slots())
+			__reallocate(__round_up(n));
+	}
+
+	circular_buffer<T, Alloc>& operator=(const circular_buffer<T, Alloc>& other)
+	{
+		if (this != &other)
+		{
+			circular_buffer<T, Alloc> tmp(other);
+			swap(tmp);
+		}
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	circular_buffer<T, Alloc>& operator=(circular_buffer<T, Alloc>&& other)
+	{
+		swap(other);
+		return *this;
+	}
+#endif
+
+	void swap(circular_buffer<T, Alloc>& other)
+	{
+		MySTL::swap(m_start, other.m_start);
+		MySTL::swap(m_mask, other.m_mask);
+		MySTL::swap(m_head, other.m_head);
+		MySTL::swap(m_size, other.m_size);
+		MySTL::swap(m_max, other.m_max);
+		MySTL::swap(m_alloc, other.m_alloc);
+	}
+};
+
+// the elements live in a heap block
+template <class T, class Alloc>
+struct is_trivially_relocatable<circular_buffer<T, Alloc> >
+{
+	typedef true_type type;
+};
+
+__NS_END
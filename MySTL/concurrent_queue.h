@@ -0,0 +1,335 @@
+#pragma once
+
+// needs C++11: std::atomic
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include "config.h"
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+
+__NS_BEGIN
+
+// raw storage for one T with malloc alignment
+template <class T>
+union __queue_storage
+{
+	char m_bytes[sizeof(T)];
+	double m_align_double;
+	long double m_align_long_double;
+	void* m_align_pointer;
+
+	T* __ptr() { return (T*)m_bytes; }
+};
+
+inline size_t __queue_slots(size_t n)
+{
+	size_t slots = 2;
+	while (slots < n)
+		slots <<= 1;
+	return slots;
+}
+
+// Bounded single producer, single consumer queue. Exactly one thread may
+// push and exactly one other thread may pop; every operation is wait-free.
+// The positions grow without wrapping and index a power of two ring. Each
+// side keeps a private copy of the other side's position and reloads it
+// only when the ring looks full (or empty), so the shared cache lines move
+// between the cores once per lap instead of once per element. Each side
+// starts a cache line of its own; on the heap that takes C++17 aligned new.
+template <class T, class Alloc = type_allocator<T> >
+class alignas(__MYSTL_CACHE_LINE) spsc_queue
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+
+private:
+	typedef typename Alloc::template rebind<__queue_storage<T> >::other SlotAllocator;
+
+	__queue_storage<T>* m_slots;
+	size_type m_mask;
+	SlotAllocator m_alloc;
+
+	// producer side
+	alignas(__MYSTL_CACHE_LINE) std::atomic<size_type> m_tail;
+	size_type m_head_cache;
+
+	// consumer side
+	alignas(__MYSTL_CACHE_LINE) std::atomic<size_type> m_head;
+	size_type m_tail_cache;
+
+	spsc_queue(const spsc_queue<T, Alloc>&);
+	spsc_queue<T, Alloc>& operator=(const spsc_queue<T, Alloc>&);
+
+	T* __slot(size_type pos) { return m_slots[pos & m_mask].__ptr(); }
+
+	// room for up to 'n' elements at 'tail', reloads the head when short
+	size_type __room(size_type tail, size_type n)
+	{
+		size_type free = m_mask + 1 - (tail - m_head_cache);
+		if (free < n)
+		{
+			m_head_cache = m_head.load(std::memory_order_acquire);
+			free = m_mask + 1 - (tail - m_head_cache);
+		}
+		return free;
+	}
+
+	size_type __ready(size_type head, size_type n)
+	{
+		size_type ready = m_tail_cache - head;
+		if (ready < n)
+		{
+			m_tail_cache = m_tail.load(std::memory_order_acquire);
+			ready = m_tail_cache - head;
+		}
+		return ready;
+	}
+
+public:
+	// holds at least 'capacity' elements, rounded up to a power of two
+	explicit spsc_queue(size_type capacity, const Alloc& a = Alloc())
+		: m_alloc(a), m_tail(0), m_head_cache(0), m_head(0), m_tail_cache(0)
+	{
+		m_mask = __queue_slots(capacity) - 1;
+		m_slots = m_alloc.allocate(m_mask + 1);
+	}
+
+	~spsc_queue()
+	{
+		for (size_type head = m_head.load(), tail = m_tail.load(); head != tail; ++head)
+			destruct(__slot(head));
+		m_alloc.deallocate(m_slots, m_mask + 1);
+	}
+
+	size_type capacity() const { return m_mask + 1; }
+	// exact only when called from one of the two threads while the other is idle
+	size_type size_approx() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+	bool empty_approx() const { return size_approx() == 0; }
+
+	// producer: false and no change when the queue is full
+	template <class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		size_type tail = m_tail.load(std::memory_order_relaxed);
+		if (__room(tail, 1) == 0)
+			return false;
+		construct(__slot(tail), MySTL::forward<Args>(args)...);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	bool try_push(const T& x) { return try_emplace(x); }
+	bool try_push(T&& x) { return try_emplace(MySTL::move(x)); }
+
+	// producer: copies up to 'n' elements from 'first', publishes them all
+	// at once and returns how many fitted
+	template <class InputIterator>
+	size_type try_push_n(InputIterator first, size_type n)
+	{
+		size_type tail = m_tail.load(std::memory_order_relaxed);
+		n = MySTL::min(n, __room(tail, n));
+		for (size_type i = 0; i < n; ++i, ++first)
+			construct(__slot(tail + i), *first);
+		m_tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	// consumer: false and no change when the queue is empty
+	bool try_pop(T& out)
+	{
+		size_type head = m_head.load(std::memory_order_relaxed);
+		if (__ready(head, 1) == 0)
+			return false;
+		T* p = __slot(head);
+		out = MySTL::move(*p);
+		destruct(p);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: moves up to 'n' elements to 'result', frees their slots at
+	// once and returns how many there were
+	template <class OutputIterator>
+	size_type try_pop_n(OutputIterator result, size_type n)
+	{
+		size_type head = m_head.load(std::memory_order_relaxed);
+		n = MySTL::min(n, __ready(head, n));
+		for (size_type i = 0; i < n; ++i, ++result)
+		{
+			T* p = __slot(head + i);
+			*result = MySTL::move(*p);
+			destruct(p);
+		}
+		m_head.store(head + n, std::memory_order_release);
+		return n;
+	}
+};
+
+template <class T>
+struct __mpmc_cell
+{
+	std::atomic<size_t> m_seq;
+	__queue_storage<T> m_storage;
+};
+
+// Bounded multi producer, multi consumer queue after Dmitry Vyukov. Every
+// cell carries a sequence number that says whose turn it is: a cell at
+// position 'pos' is free for the producer of 'pos' when its sequence is
+// 'pos' and holds an element for the consumer of 'pos' when it is 'pos + 1'.
+// Producers and consumers claim positions with a CAS on their own counter
+// and never touch the other side's counter, a full or empty queue is seen
+// from the cell alone. Lock-free, not wait-free: a thread stopped between
+// claiming a cell and publishing it holds up the ones behind it. The two
+// counters are aligned to cache lines of their own like in spsc_queue.
+template <class T, class Alloc = type_allocator<T> >
+class alignas(__MYSTL_CACHE_LINE) mpmc_queue
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+
+private:
+	typedef __mpmc_cell<T> Cell;
+	typedef typename Alloc::template rebind<Cell>::other CellAllocator;
+	typedef ptrdiff_t difference_type;
+
+	Cell* m_cells;
+	size_type m_mask;
+	CellAllocator m_alloc;
+	alignas(__MYSTL_CACHE_LINE) std::atomic<size_type> m_enqueue_pos;
+	alignas(__MYSTL_CACHE_LINE) std::atomic<size_type> m_dequeue_pos;
+
+	mpmc_queue(const mpmc_queue<T, Alloc>&);
+	mpmc_queue<T, Alloc>& operator=(const mpmc_queue<T, Alloc>&);
+
+	// how far the cell at 'pos' is from being ready for position 'pos'
+	difference_type __lag(size_type pos, size_type lag) const
+	{
+		size_type seq = m_cells[pos & m_mask].m_seq.load(std::memory_order_acquire);
+		return difference_type(seq - (pos + lag));
+	}
+
+	// claims up to 'n' consecutive cells of 'counter' whose sequence is
+	// their position + 'lag', returns how many and their first position
+	size_type __claim(std::atomic<size_type>& counter, size_type lag, size_type n, size_type& first)
+	{
+		if (n == 0)
+			return 0;
+		size_type pos = counter.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			size_type k = 0;
+			while (k < n && __lag(pos + k, lag) == 0)
+				++k;
+			if (k == 0)
+			{
+				// behind: the queue is full (or empty), ahead: 'pos' is taken
+				if (__lag(pos, lag) < 0)
+					return 0;
+				pos = counter.load(std::memory_order_relaxed);
+			}
+			else if (counter.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+			{
+				first = pos;
+				return k;
+			}
+		}
+	}
+
+public:
+	// holds at least 'capacity' elements, rounded up to a power of two
+	explicit mpmc_queue(size_type capacity, const Alloc& a = Alloc())
+		: m_alloc(a), m_enqueue_pos(0), m_dequeue_pos(0)
+	{
+		m_mask = __queue_slots(capacity) - 1;
+		m_cells = m_alloc.allocate(m_mask + 1);
+		for (size_type i = 0; i <= m_mask; ++i)
+			new (&m_cells[i].m_seq) std::atomic<size_t>(i);
+	}
+
+	~mpmc_queue()
+	{
+		for (size_type pos = m_dequeue_pos.load(), end = m_enqueue_pos.load(); pos != end; ++pos)
+			destruct(m_cells[pos & m_mask].m_storage.__ptr());
+		m_alloc.deallocate(m_cells, m_mask + 1);
+	}
+
+	size_type capacity() const { return m_mask + 1; }
+	size_type size_approx() const
+	{
+		size_type tail = m_enqueue_pos.load(std::memory_order_acquire);
+		size_type head = m_dequeue_pos.load(std::memory_order_acquire);
+		return difference_type(tail - head) > 0 ? tail - head : 0;
+	}
+	bool empty_approx() const { return size_approx() == 0; }
+
+	// false and no change when the queue is full
+	template <class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		size_type pos;
+		if (__claim(m_enqueue_pos, 0, 1, pos) == 0)
+			return false;
+		Cell& cell = m_cells[pos & m_mask];
+		construct(cell.m_storage.__ptr(), MySTL::forward<Args>(args)...);
+		cell.m_seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+	bool try_push(const T& x) { return try_emplace(x); }
+	bool try_push(T&& x) { return try_emplace(MySTL::move(x)); }
+
+	// claims a run of up to 'n' free cells with one CAS and copies the
+	// first elements of 'first' into them, returns the length of the run
+	template <class InputIterator>
+	size_type try_push_n(InputIterator first, size_type n)
+	{
+		size_type pos;
+		n = __claim(m_enqueue_pos, 0, n, pos);
+		for (size_type i = 0; i < n; ++i, ++first)
+		{
+			Cell& cell = m_cells[(pos + i) & m_mask];
+			construct(cell.m_storage.__ptr(), *first);
+			cell.m_seq.store(pos + i + 1, std::memory_order_release);
+		}
+		return n;
+	}
+
+	// false and no change when the queue is empty
+	bool try_pop(T& out)
+	{
+		size_type pos;
+		if (__claim(m_dequeue_pos, 1, 1, pos) == 0)
+			return false;
+		Cell& cell = m_cells[pos & m_mask];
+		T* p = cell.m_storage.__ptr();
+		out = MySTL::move(*p);
+		destruct(p);
+		cell.m_seq.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	// claims a run of up to 'n' full cells with one CAS and moves their
+	// elements to 'result', returns the length of the run
+	template <class OutputIterator>
+	size_type try_pop_n(OutputIterator result, size_type n)
+	{
+		size_type pos;
+		n = __claim(m_dequeue_pos, 1, n, pos);
+		for (size_type i = 0; i < n; ++i, ++result)
+		{
+			Cell& cell = m_cells[(pos + i) & m_mask];
+			T* p = cell.m_storage.__ptr();
+			*result = MySTL::move(*p);
+			destruct(p);
+			cell.m_seq.store(pos + i + m_mask + 1, std::memory_order_release);
+		}
+		return n;
+	}
+};
+
+__NS_END
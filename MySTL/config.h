@@ -1,4 +1,32 @@
 #pragma once
 
 #define __NS_BEGIN namespace MySTL {
-#define __NS_END }
\ No newline at end of file
+#define __NS_END }
+
+// rvalue references, variadic templates and noexcept
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define __MYSTL_CXX11
+#endif
+
+// deque blocks hold a power of two elements, so that deque iterator
+// arithmetic is shifts and masks; define as 0 for the SGI block sizes
+#ifndef __MYSTL_DEQUE_POW2_BUFFER
+#define __MYSTL_DEQUE_POW2_BUFFER 1
+#endif
+
+// data written by different threads is kept this many bytes apart
+#ifndef __MYSTL_CACHE_LINE
+#define __MYSTL_CACHE_LINE 64
+#endif
+
+// the flat hash table matches 16 control bytes at once with SSE2, which
+// every x86-64 target has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define __MYSTL_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#define __MYSTL_ALIGNOF(T) __alignof(T)
+#else
+#define __MYSTL_ALIGNOF(T) __alignof__(T)
+#endif
@@ -25,16 +25,25 @@
  *      if and only if the pointer is in the range [start.node, finish.node].
  */
 
-__NS_BEGIN
-
 #include "algo_base.h"
 #include "allocator.h"
 #include "initialize.h"
 
-size_t __deque_buf_size(size_t __size)
+__NS_BEGIN
+
+// elements per block for elements of 'Size' bytes
+template <size_t Size>
+struct __deque_buf_size
 {
-	return __size < 512 ? size_t(512 / __size) : size_t(1);
-}
+	enum { __count = Size < 512 ? 512 / Size : 1 };
+#if __MYSTL_DEQUE_POW2_BUFFER
+	enum { value = __count >= 512 ? 512 : __count >= 256 ? 256 : __count >= 128 ? 128 :
+		__count >= 64 ? 64 : __count >= 32 ? 32 : __count >= 16 ? 16 : __count >= 8 ? 8 :
+		__count >= 4 ? 4 : __count >= 2 ? 2 : 1 };
+#else
+	enum { value = __count };
+#endif
+};
 
 template <class Tp, class Ref, class Ptr>
 struct __deque_iterator
@@ -55,7 +64,7 @@ struct __deque_iterator
 	Tp* m_last;
 	Map_pointer m_node;
 
-	static size_type __buffer_size() { return __deque_buf_size(sizeof(Tp)); }
+	static size_type __buffer_size() { return __deque_buf_size<sizeof(Tp)>::value; }
 
 	void __set_node(Map_pointer new_node)
 	{
@@ -103,6 +112,7 @@ struct __deque_iterator
 	}
 	Self operator--(int) { Self tmp = *this; --*this; return tmp; }
 
+	// the divisions are unsigned, by a power of two they become shifts
 	Self& operator+=(difference_type n)
 	{
 		difference_type buffer_size = difference_type(__buffer_size());
@@ -112,7 +122,8 @@ struct __deque_iterator
 		else
 		{
 			difference_type node_offset = offset > 0 ? 
-				offset / buffer_size : -((-offset - 1) / buffer_size) - 1;
+				difference_type(size_type(offset) / __buffer_size()) :
+				-difference_type(size_type(-offset - 1) / __buffer_size()) - 1;
 			__set_node(m_node + node_offset);
 			m_cur = m_first + (offset - node_offset * buffer_size);
 		}
@@ -148,6 +159,22 @@ __deque_iterator<Tp, Ref, Ptr> operator+(ptrdiff_t n, const __deque_iterator<Tp,
 	return x + n;
 }
 
+// the blocks are the segments
+template <class Tp, class Ref, class Ptr>
+struct segmented_iterator_traits<__deque_iterator<Tp, Ref, Ptr> >
+{
+	typedef true_type is_segmented;
+	typedef __deque_iterator<Tp, Ref, Ptr> iterator;
+	typedef Tp** segment_iterator;
+	typedef Ptr local_iterator;
+
+	static segment_iterator segment(const iterator& i) { return i.m_node; }
+	static local_iterator local(const iterator& i) { return i.m_cur; }
+	static local_iterator begin(segment_iterator s) { return *s; }
+	static local_iterator end(segment_iterator s) { return *s + iterator::__buffer_size(); }
+	static iterator compose(segment_iterator s, local_iterator l) { return iterator((Tp*)l, s); }
+};
+
 template <class Tp, class Alloc = allocator>
 class deque
 {
@@ -172,13 +199,29 @@ private:
 	size_type m_map_size;
 	iterator m_start;
 	iterator m_finish;
+	pointer m_spare;	// the last freed block, handed out again first
 
 	enum { __initial_map_size = 8 };
 
-	static size_t __buffer_size() { return __deque_buf_size(sizeof(Tp)); }
+	static size_t __buffer_size() { return __deque_buf_size<sizeof(Tp)>::value; }
 
-	pointer __allocate_node() { return NodeAllocator::allocate(__deque_buf_size(sizeof(Tp))); }
-	void __deallocate_node(pointer p) { NodeAllocator::deallocate(p, __deque_buf_size(sizeof(Tp))); }
+	pointer __allocate_node()
+	{
+		if (m_spare == 0)
+			return NodeAllocator::allocate(__buffer_size());
+		pointer p = m_spare;
+		m_spare = 0;
+		return p;
+	}
+	// one block is kept back, so a deque used as a queue, which frees a block
+	// at the front whenever it needs one at the back, stops allocating
+	void __deallocate_node(pointer p)
+	{
+		if (m_spare == 0)
+			m_spare = p;
+		else
+			NodeAllocator::deallocate(p, __buffer_size());
+	}
 	Map_pointer __allocate_map(size_t n) { return MapAllocator::allocate(n); }
 	void __deallocate_map(Map_pointer p, size_t n) { MapAllocator::deallocate(p, n); }
 
@@ -196,7 +239,7 @@ private:
 
 	void __initialize_map(size_t num_elements)
 	{
-		size_t num_nodes = num_elements / __deque_buf_size(sizeof(Tp)) + 1;
+		size_t num_nodes = num_elements / __buffer_size() + 1;
 		m_map_size = max((size_t) __initial_map_size, num_nodes + 2);
 		m_map = __allocate_map(m_map_size);
 
@@ -208,7 +251,7 @@ private:
 		m_start.m_cur = m_start.m_first;
 
 		m_finish.__set_node(nfinish - 1);
-		m_finish.m_cur = m_finish.m_first + num_elements % __deque_buf_size(sizeof(Tp));
+		m_finish.m_cur = m_finish.m_first + num_elements % __buffer_size();
 	}
 
 	void __fill_initialize(const value_type& x)
@@ -262,7 +305,15 @@ private:
 		value_type t_copy = t;
 		__reserve_map_at_back();
 		*(m_finish.m_node + 1) = __allocate_node();
-		construct(m_finish.m_cur, t_copy);
+		try
+		{
+			construct(m_finish.m_cur, t_copy);
+		}
+		catch (...)
+		{
+			__deallocate_node(*(m_finish.m_node + 1));
+			throw;
+		}
 		m_finish.__set_node(m_finish.m_node + 1);
 		m_finish.m_cur = m_finish.m_first;
 	}
@@ -272,9 +323,17 @@ private:
 		value_type t_copy = t;
 		__reserve_map_at_front();
 		*(m_start.m_node - 1) = __allocate_node();
+		try
+		{
+			construct(*(m_start.m_node - 1) + __buffer_size() - 1, t_copy);
+		}
+		catch (...)
+		{
+			__deallocate_node(*(m_start.m_node - 1));
+			throw;
+		}
 		m_start.__set_node(m_start.m_node - 1);
 		m_start.m_cur = m_start.m_last - 1;
-		construct(m_start.m_cur, t_copy);
 	}
 
 	void __pop_back_aux()
@@ -299,6 +358,67 @@ private:
 			__reallocate_map(nodes_to_add, false);
 	}
 
+	// allocates the blocks for 'n' more elements at the back, returns the
+	// iterator the finish will have then
+	iterator __reserve_elements_at_back(size_type n)
+	{
+		size_type vacancies = (m_finish.m_last - m_finish.m_cur) - 1;
+		if (n > vacancies)
+		{
+			size_type new_nodes = (n - vacancies + __buffer_size() - 1) / __buffer_size();
+			__reserve_map_at_back(new_nodes);
+			size_type i = 1;
+			try
+			{
+				for ( ; i <= new_nodes; ++i)
+					*(m_finish.m_node + i) = __allocate_node();
+			}
+			catch (...)
+			{
+				__destroy_nodes(m_finish.m_node + 1, m_finish.m_node + i);
+				throw;
+			}
+		}
+		return m_finish + difference_type(n);
+	}
+
+	template <class InputIterator>
+	void __append(InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		for ( ; first != last; ++first)
+			push_back(*first);
+	}
+
+	// whole blocks at a time, range_construct copies trivial types with memmove;
+	// if a copy throws, the elements of the full blocks stay appended and
+	// the blocks reserved beyond them are freed
+	template <class ForwardIterator>
+	void __append(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = MySTL::distance(first, last);
+		iterator new_finish = __reserve_elements_at_back(n);
+		try
+		{
+			while (n > 0)
+			{
+				size_type len = MySTL::min(n, size_type(m_finish.m_last - m_finish.m_cur));
+				ForwardIterator mid = first;
+				MySTL::advance(mid, len);
+				range_construct(first, mid, m_finish.m_cur);
+				first = mid;
+				n -= len;
+				if (n > 0)
+					m_finish += difference_type(len);
+			}
+		}
+		catch (...)
+		{
+			__destroy_nodes(m_finish.m_node + 1, new_finish.m_node + 1);
+			throw;
+		}
+		m_finish = new_finish;
+	}
+
 	void __reserve_map_at_front(size_type nodes_to_add = 1)
 	{
 		if (nodes_to_add > size_type(m_start.m_node - m_map))
@@ -316,9 +436,9 @@ private:
 			new_nstart = m_map + (m_map_size - new_num_nodes) / 2
 				+ (add_at_front ? nodes_to_add : 0);
 			if (new_nstart < m_start.m_node)
-				copy(m_start.m_node, m_finish.m_node + 1, new_nstart);
+				MySTL::copy(m_start.m_node, m_finish.m_node + 1, new_nstart);
 			else
-				copy_backward(m_start.m_node, m_finish.m_node + 1,
+				MySTL::copy_backward(m_start.m_node, m_finish.m_node + 1,
 				new_nstart + old_num_nodes);
 		}
 		else
@@ -329,7 +449,7 @@ private:
 			Map_pointer __new_map = __allocate_map(new_map_size);
 			new_nstart = __new_map + (new_map_size - new_num_nodes) / 2
 				+ (add_at_front ? nodes_to_add : 0);
-			copy(m_start.m_node, m_finish.m_node + 1, new_nstart);
+			MySTL::copy(m_start.m_node, m_finish.m_node + 1, new_nstart);
 			__deallocate_map(m_map, m_map_size);
 
 			m_map = __new_map;
@@ -340,7 +460,146 @@ private:
 		m_finish.__set_node(new_nstart + old_num_nodes - 1);
 	}
 
-	iterator __insert_aux(iterator pos, const value_type& x)
+	// extends the deque by one uninitialized slot at the front / back
+	void __grow_front_slot()
+	{
+		if (m_start.m_cur == m_start.m_first)
+		{
+			__reserve_map_at_front();
+			*(m_start.m_node - 1) = __allocate_node();
+			m_start.__set_node(m_start.m_node - 1);
+			m_start.m_cur = m_start.m_last;
+		}
+		--m_start.m_cur;
+	}
+
+	void __grow_back_slot()
+	{
+		if (m_finish.m_cur == m_finish.m_last - 1)
+		{
+			__reserve_map_at_back();
+			*(m_finish.m_node + 1) = __allocate_node();
+			m_finish.__set_node(m_finish.m_node + 1);
+			m_finish.m_cur = m_finish.m_first;
+		}
+		else
+			++m_finish.m_cur;
+	}
+
+	// gives up the first / last slot, whose element is already gone
+	void __shrink_front_slot()
+	{
+		if (m_start.m_cur != m_start.m_last - 1)
+			++m_start.m_cur;
+		else
+		{
+			__deallocate_node(m_start.m_first);
+			m_start.__set_node(m_start.m_node + 1);
+			m_start.m_cur = m_start.m_first;
+		}
+	}
+
+	void __shrink_back_slot()
+	{
+		if (m_finish.m_cur != m_finish.m_first)
+			--m_finish.m_cur;
+		else
+		{
+			__deallocate_node(m_finish.m_first);
+			m_finish.__set_node(m_finish.m_node - 1);
+			m_finish.m_cur = m_finish.m_last - 1;
+		}
+	}
+
+	// memmove of [first, last) to 'result', one contiguous piece at a time;
+	// 'result' lies before 'first'
+	static void __relocate_forward(iterator first, iterator last, iterator result)
+	{
+		difference_type n = last - first;
+		while (n > 0)
+		{
+			difference_type len = min(n, min(difference_type(first.m_last - first.m_cur),
+				difference_type(result.m_last - result.m_cur)));
+			memmove((void*)result.m_cur, (void*)first.m_cur, len * sizeof(Tp));
+			first += len;
+			result += len;
+			n -= len;
+		}
+	}
+
+	// the same for a 'result' range ending after 'last', back to front
+	static void __relocate_backward(iterator first, iterator last, iterator result)
+	{
+		difference_type n = last - first;
+		while (n > 0)
+		{
+			Tp* last_end = last.m_cur;
+			difference_type last_len = last.m_cur - last.m_first;
+			if (last_len == 0)
+			{
+				last_len = __buffer_size();
+				last_end = *(last.m_node - 1) + last_len;
+			}
+			Tp* result_end = result.m_cur;
+			difference_type result_len = result.m_cur - result.m_first;
+			if (result_len == 0)
+			{
+				result_len = __buffer_size();
+				result_end = *(result.m_node - 1) + result_len;
+			}
+			difference_type len = min(n, min(last_len, result_len));
+			memmove((void*)(result_end - len), (void*)(last_end - len), len * sizeof(Tp));
+			last -= len;
+			result -= len;
+			n -= len;
+		}
+	}
+
+	// trivially relocatable elements are shifted with memmove instead of
+	// being copied one by one through a new element at the end. The copy of
+	// x is made in the new end slot before anything moves, so a throwing
+	// copy leaves the deque as it was; its bytes are carried to 'pos' last.
+	iterator __insert_aux(iterator pos, const value_type& x, true_type)
+	{
+		difference_type index = pos - m_start;
+		char x_bytes[sizeof(Tp)];
+		if (size_type(index) < this->size() / 2)
+		{
+			__grow_front_slot();
+			try
+			{
+				construct(m_start.m_cur, x);
+			}
+			catch (...)
+			{
+				__shrink_front_slot();
+				throw;
+			}
+			memcpy(x_bytes, (void*)m_start.m_cur, sizeof(Tp));
+			__relocate_forward(m_start + 1, m_start + index + 1, m_start);
+		}
+		else
+		{
+			__grow_back_slot();
+			iterator last = m_finish - 1;
+			try
+			{
+				construct(last.m_cur, x);
+			}
+			catch (...)
+			{
+				__shrink_back_slot();
+				throw;
+			}
+			memcpy(x_bytes, (void*)last.m_cur, sizeof(Tp));
+			__relocate_backward(m_start + index, last, m_finish);
+		}
+		pos = m_start + index;
+		memcpy((void*)pos.m_cur, x_bytes, sizeof(Tp));
+		return pos;
+	}
+
+	iterator __insert_aux(iterator pos, const value_type& x, false_type)
 	{
 		difference_type index = pos - m_start;
 		value_type __x_copy = x;
@@ -372,26 +631,29 @@ private:
 
 public:
 	deque() 
-		: m_map(0), m_map_size(0),  m_start(), m_finish() 
+		: m_map(0), m_map_size(0),  m_start(), m_finish(), m_spare(0)
 	{ __initialize_map(0); }
 	explicit deque(size_type num_elements) 
-		: m_map(0), m_map_size(0),  m_start(), m_finish()
+		: m_map(0), m_map_size(0),  m_start(), m_finish(), m_spare(0)
 	{ 
 		__initialize_map(num_elements);
 		__fill_initialize(value_type());
 	}
 	deque(size_type n, const value_type& value) 
+		: m_spare(0)
 	{ 
-		__initialize_map(num_elements);
+		__initialize_map(n);
 		__fill_initialize(value); 
 	}
 	deque(const deque& x)
+		: m_spare(0)
 	{
 		__initialize_map(x.size());
 		range_construct(x.begin(), x.end(), m_start);
 	}
 	template <class InputIterator>
 	deque(InputIterator first, InputIterator last)
+		: m_spare(0)
 	{
 		typedef typename is_integer<InputIterator>::integer integer;
 		__initialize_aux(first, last, integer());
@@ -405,6 +667,8 @@ public:
 			__destroy_nodes(m_start.m_node, m_finish.m_node + 1);
 			__deallocate_map(m_map, m_map_size);
 		}
+		if (m_spare)
+			NodeAllocator::deallocate(m_spare, __buffer_size());
 	}
 
 	iterator begin() { return m_start; }
@@ -429,6 +693,7 @@ public:
 		::swap(m_finish, x.m_finish);
 		::swap(m_map, x.m_map);
 		::swap(m_map_size, x.m_map_size);
+		::swap(m_spare, x.m_spare);
 	}
 
 	void push_back(const value_type& t)
@@ -442,6 +707,13 @@ public:
 			__push_back_aux(t);
 	}
 
+	// appends ['first', 'last') at the back
+	template <class InputIterator>
+	void append(InputIterator first, InputIterator last)
+	{
+		__append(first, last, iterator_category(first));
+	}
+
 	void push_front(const value_type& t)
 	{
 		if (m_start.m_cur != m_start.m_first)
@@ -491,11 +763,36 @@ public:
 		}
 		else
 		{
-			return __insert_aux(position, x);
+			typedef typename is_trivially_relocatable<Tp>::type relocatable;
+			return __insert_aux(position, x, relocatable());
 		}
 	}
 
 	iterator erase(iterator pos)
+	{
+		typedef typename is_trivially_relocatable<Tp>::type relocatable;
+		return __erase_aux(pos, relocatable());
+	}
+
+private:
+	iterator __erase_aux(iterator pos, true_type)
+	{
+		difference_type index = pos - m_start;
+		destruct(pos.m_cur);
+		if (size_type(index) < (this->size() >> 1))
+		{
+			__relocate_backward(m_start, pos, pos + 1);
+			__shrink_front_slot();
+		}
+		else
+		{
+			__relocate_forward(pos + 1, m_finish, pos);
+			__shrink_back_slot();
+		}
+		return m_start + index;
+	}
+
+	iterator __erase_aux(iterator pos, false_type)
 	{
 		iterator len = pos;
 		++len;
@@ -513,6 +810,8 @@ public:
 		return m_start + index;
 	}
 
+public:
+
 	void resize(size_type new_size, const value_type& x)
 	{
 		const size_type len = size();
@@ -545,4 +844,11 @@ public:
 	}
 };
 
+// the iterators point into the map and the nodes, not into the object
+template <class Tp, class Alloc>
+struct is_trivially_relocatable<deque<Tp, Alloc> >
+{
+	typedef true_type type;
+};
+
 __NS_END
\ No newline at end of file
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <stddef.h>
+#include <limits.h>
+#include "config.h"
+#include "allocator.h"
+#include "vector.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+__NS_BEGIN
+
+// number of set bits in 'w'
+inline size_t __bit_count(size_t w)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll((unsigned long long)w);
+#else
+	size_t n = 0;
+	for ( ; w; w &= w - 1)
+		++n;
+	return n;
+#endif
+}
+
+// index of the lowest set bit, 'w' must not be 0
+inline size_t __bit_scan_forward(size_t w)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll((unsigned long long)w);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, w);
+	return index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, w);
+	return index;
+#else
+	size_t index = 0;
+	for ( ; (w & 1) == 0; w >>= 1)
+		++index;
+	return index;
+#endif
+}
+
+// Bit set of run-time size, one bit per flag packed into machine words.
+// count, find_first/find_next and the logical operators work a word at a
+// time. Bits beyond size() in the last word are always kept 0.
+template <class Alloc = type_allocator<size_t> >
+class dynamic_bitset
+{
+public:
+	typedef size_t word_type;
+	typedef size_t size_type;
+	typedef Alloc allocator_type;
+
+	enum { bits_per_word = sizeof(word_type) * CHAR_BIT };
+	static const size_type npos = (size_type)-1;
+
+	class reference
+	{
+		friend class dynamic_bitset;
+		word_type* m_word;
+		word_type m_mask;
+
+		reference(word_type* word, word_type mask) : m_word(word), m_mask(mask) {}
+	public:
+		operator bool() const { return (*m_word & m_mask) != 0; }
+		bool operator~() const { return (*m_word & m_mask) == 0; }
+		reference& operator=(bool x)
+		{
+			if (x)
+				*m_word |= m_mask;
+			else
+				*m_word &= ~m_mask;
+			return *this;
+		}
+		reference& operator=(const reference& x) { return *this = bool(x); }
+		reference& flip()
+		{
+			*m_word ^= m_mask;
+			return *this;
+		}
+	};
+
+private:
+	typedef vector<word_type, Alloc> WordVector;
+
+	WordVector m_words;
+	size_type m_size;
+
+	static size_type __word_index(size_type pos) { return pos / bits_per_word; }
+	static word_type __bit_mask(size_type pos) { return word_type(1) << (pos % bits_per_word); }
+	static size_type __words_for(size_type n) { return (n + bits_per_word - 1) / bits_per_word; }
+
+	// clears the unused bits of the last word
+	void __trim()
+	{
+		size_type extra = m_size % bits_per_word;
+		if (extra != 0)
+			m_words[m_words.size() - 1] &= (word_type(1) << extra) - 1;
+	}
+
+	// first set bit at or after word 'index'
+	size_type __find_from_word(size_type index) const
+	{
+		for ( ; index < m_words.size(); ++index)
+			if (m_words[index] != 0)
+				return index * bits_per_word + __bit_scan_forward(m_words[index]);
+		return npos;
+	}
+
+public:
+	dynamic_bitset() : m_size(0) {}
+	explicit dynamic_bitset(const Alloc& a) : m_words(a), m_size(0) {}
+	explicit dynamic_bitset(size_type n, bool value = false, const Alloc& a = Alloc())
+		: m_words(__words_for(n), value ? ~word_type(0) : word_type(0), a), m_size(n)
+	{
+		__trim();
+	}
+
+	size_type size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	size_type num_words() const { return m_words.size(); }
+	allocator_type get_allocator() const { return m_words.get_allocator(); }
+
+	reference operator[](size_type pos) { return reference(&m_words[__word_index(pos)], __bit_mask(pos)); }
+	bool operator[](size_type pos) const { return test(pos); }
+	bool test(size_type pos) const { return (m_words[__word_index(pos)] & __bit_mask(pos)) != 0; }
+
+	dynamic_bitset& set(size_type pos, bool value = true)
+	{
+		(*this)[pos] = value;
+		return *this;
+	}
+	dynamic_bitset& reset(size_type pos)
+	{
+		m_words[__word_index(pos)] &= ~__bit_mask(pos);
+		return *this;
+	}
+	dynamic_bitset& flip(size_type pos)
+	{
+		m_words[__word_index(pos)] ^= __bit_mask(pos);
+		return *this;
+	}
+
+	dynamic_bitset& set()
+	{
+		MySTL::fill(m_words.begin(), m_words.end(), ~word_type(0));
+		__trim();
+		return *this;
+	}
+	dynamic_bitset& reset()
+	{
+		MySTL::fill(m_words.begin(), m_words.end(), word_type(0));
+		return *this;
+	}
+	dynamic_bitset& flip()
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			m_words[i] = ~m_words[i];
+		__trim();
+		return *this;
+	}
+
+	// sets the bits in ['first', 'last') to 'value', whole words at a time
+	dynamic_bitset& set_range(size_type first, size_type last, bool value = true)
+	{
+		if (first >= last)
+			return *this;
+		size_type first_word = __word_index(first);
+		size_type last_word = __word_index(last - 1);
+		word_type first_mask = ~word_type(0) << (first % bits_per_word);
+		word_type last_mask = ~word_type(0) >> (bits_per_word - 1 - (last - 1) % bits_per_word);
+		if (first_word == last_word)
+			first_mask &= last_mask;
+		for (size_type i = first_word; i <= last_word; ++i)
+		{
+			word_type mask = ~word_type(0);
+			if (i == first_word)
+				mask = first_mask;
+			else if (i == last_word)
+				mask = last_mask;
+			if (value)
+				m_words[i] |= mask;
+			else
+				m_words[i] &= ~mask;
+		}
+		return *this;
+	}
+	dynamic_bitset& reset_range(size_type first, size_type last) { return set_range(first, last, false); }
+
+	void resize(size_type n, bool value = false)
+	{
+		size_type old_size = m_size;
+		m_words.resize(__words_for(n), word_type(0));
+		m_size = n;
+		if (n > old_size && value)
+			set_range(old_size, n);
+		__trim();
+	}
+	void push_back(bool value)
+	{
+		resize(m_size + 1);
+		if (value)
+			set(m_size - 1);
+	}
+	void clear()
+	{
+		m_words.clear();
+		m_size = 0;
+	}
+
+	size_type count() const
+	{
+		size_type n = 0;
+		for (size_type i = 0; i < m_words.size(); ++i)
+			n += __bit_count(m_words[i]);
+		return n;
+	}
+	bool any() const
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			if (m_words[i] != 0)
+				return true;
+		return false;
+	}
+	bool none() const { return !any(); }
+	bool all() const { return count() == m_size; }
+
+	// position of the first set bit, npos if there is none
+	size_type find_first() const { return __find_from_word(0); }
+
+	// position of the first set bit after 'pos', npos if there is none
+	// (also for pos == npos)
+	size_type find_next(size_type pos) const
+	{
+		if (pos >= m_size || ++pos >= m_size)
+			return npos;
+		size_type index = __word_index(pos);
+		word_type w = m_words[index] & (~word_type(0) << (pos % bits_per_word));
+		if (w != 0)
+			return index * bits_per_word + __bit_scan_forward(w);
+		return __find_from_word(index + 1);
+	}
+
+	// the logical operators need operands of the same size
+	dynamic_bitset& operator&=(const dynamic_bitset& x)
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			m_words[i] &= x.m_words[i];
+		return *this;
+	}
+	dynamic_bitset& operator|=(const dynamic_bitset& x)
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			m_words[i] |= x.m_words[i];
+		return *this;
+	}
+	dynamic_bitset& operator^=(const dynamic_bitset& x)
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			m_words[i] ^= x.m_words[i];
+		return *this;
+	}
+	// clears the bits that are set in 'x'
+	dynamic_bitset& operator-=(const dynamic_bitset& x)
+	{
+		for (size_type i = 0; i < m_words.size(); ++i)
+			m_words[i] &= ~x.m_words[i];
+		return *this;
+	}
+	dynamic_bitset operator~() const
+	{
+		dynamic_bitset tmp(*this);
+		tmp.flip();
+		return tmp;
+	}
+
+	bool operator==(const dynamic_bitset& x) const
+	{
+		if (m_size != x.m_size)
+			return false;
+		for (size_type i = 0; i < m_words.size(); ++i)
+			if (m_words[i] != x.m_words[i])
+				return false;
+		return true;
+	}
+	bool operator!=(const dynamic_bitset& x) const { return !(*this == x); }
+
+	void swap(dynamic_bitset& x)
+	{
+		m_words.swap(x.m_words);
+		MySTL::swap(m_size, x.m_size);
+	}
+
+	// raw words, for scanning outside the class
+	const word_type* data() const { return m_words.begin(); }
+};
+
+template <class Alloc>
+const typename dynamic_bitset<Alloc>::size_type dynamic_bitset<Alloc>::npos;
+
+template <class Alloc>
+inline dynamic_bitset<Alloc> operator&(const dynamic_bitset<Alloc>& x, const dynamic_bitset<Alloc>& y)
+{
+	dynamic_bitset<Alloc> tmp(x);
+	return tmp &= y;
+}
+
+template <class Alloc>
+inline dynamic_bitset<Alloc> operator|(const dynamic_bitset<Alloc>& x, const dynamic_bitset<Alloc>& y)
+{
+	dynamic_bitset<Alloc> tmp(x);
+	return tmp |= y;
+}
+
+template <class Alloc>
+inline dynamic_bitset<Alloc> operator^(const dynamic_bitset<Alloc>& x, const dynamic_bitset<Alloc>& y)
+{
+	dynamic_bitset<Alloc> tmp(x);
+	return tmp ^= y;
+}
+
+template <class Alloc>
+inline dynamic_bitset<Alloc> operator-(const dynamic_bitset<Alloc>& x, const dynamic_bitset<Alloc>& y)
+{
+	dynamic_bitset<Alloc> tmp(x);
+	return tmp -= y;
+}
+
+// only holds a vector
+template <class Alloc>
+struct is_trivially_relocatable<dynamic_bitset<Alloc> >
+{
+	typedef true_type type;
+};
+
+__NS_END
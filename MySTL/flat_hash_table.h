@@ -0,0 +1,742 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include "config.h"
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+#include "iterator_base.h"
+#include "functor.h"
+#include "pair.h"
+#include "hash_function.h"
+#include "dynamic_bitset.h"
+
+#if defined(__MYSTL_SSE2)
+#include <emmintrin.h>
+#endif
+
+__NS_BEGIN
+
+// One control byte per slot. A full slot holds the low 7 bits of its
+// hash, the other states have the high bit set.
+typedef signed char __flat_ctrl;
+
+enum
+{
+	__flat_empty = -128,
+	__flat_deleted = -2,
+	__flat_sentinel = -1	// after the last slot, stops the iterators
+};
+
+// 16 control bytes matched at once, bit i of a mask stands for slot i
+struct __flat_group
+{
+	enum { width = 16 };
+
+#if defined(__MYSTL_SSE2)
+	__m128i m_ctrl;
+
+	explicit __flat_group(const __flat_ctrl* p) : m_ctrl(_mm_loadu_si128((const __m128i*)p)) {}
+
+	unsigned __match(__flat_ctrl tag) const
+	{
+		return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), m_ctrl));
+	}
+	// empty and deleted slots
+	unsigned __match_free() const { return (unsigned)_mm_movemask_epi8(m_ctrl); }
+#else
+	const __flat_ctrl* m_ctrl;
+
+	explicit __flat_group(const __flat_ctrl* p) : m_ctrl(p) {}
+
+	unsigned __match(__flat_ctrl tag) const
+	{
+		unsigned mask = 0;
+		for (int i = 0; i < width; ++i)
+			if (m_ctrl[i] == tag)
+				mask |= 1u << i;
+		return mask;
+	}
+	unsigned __match_free() const
+	{
+		unsigned mask = 0;
+		for (int i = 0; i < width; ++i)
+			if (m_ctrl[i] < 0)
+				mask |= 1u << i;
+		return mask;
+	}
+#endif
+
+	unsigned __match_empty() const { return __match((__flat_ctrl)__flat_empty); }
+};
+
+// hash<int> is the identity and the string hash fills the low bits
+// poorly; the multiply and shift spread every input bit over the bits the
+// table takes its tags and groups from
+inline size_t __flat_mix(size_t h)
+{
+#if defined(_WIN64) || defined(__LP64__) || defined(__x86_64__)
+	h *= (size_t)0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 32);
+#else
+	h *= 0x9E3779B9u;
+	return h ^ (h >> 16);
+#endif
+}
+
+template <class Value, class Ref, class Ptr>
+struct __flat_hashtable_iterator
+{
+	typedef forward_iterator_tag category;
+	typedef Value value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef ptrdiff_t difference_type;
+	typedef __flat_hashtable_iterator<Value, Ref, Ptr> Self;
+	typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+
+	const __flat_ctrl* m_ctrl;
+	Value* m_slot;
+
+	__flat_hashtable_iterator() : m_ctrl(0), m_slot(0) {}
+	__flat_hashtable_iterator(const __flat_ctrl* ctrl, Value* slot) : m_ctrl(ctrl), m_slot(slot) {}
+	__flat_hashtable_iterator(const iterator& x) : m_ctrl(x.m_ctrl), m_slot(x.m_slot) {}
+
+	reference operator*() const { return *m_slot; }
+	pointer operator->() const { return m_slot; }
+	bool operator==(const Self& x) const { return m_slot == x.m_slot; }
+	bool operator!=(const Self& x) const { return m_slot != x.m_slot; }
+
+	// moves to the next full slot or the sentinel
+	void __skip_free()
+	{
+		while (*m_ctrl < 0 && *m_ctrl != __flat_sentinel)
+		{
+			++m_ctrl;
+			++m_slot;
+		}
+	}
+
+	Self& operator++()
+	{
+		++m_ctrl;
+		++m_slot;
+		__skip_free();
+		return *this;
+	}
+	Self operator++(int) { Self tmp = *this; ++*this; return tmp; }
+};
+
+// Open addressing hash table that keeps its elements in one slot array,
+// so a lookup touches no node. Next to the slots is an array of control
+// bytes; a lookup compares the 7 bit tag of its hash against a whole group
+// of 16 control bytes at once and looks at the slots whose tag matches.
+// Groups are probed in triangular order until one with an empty slot. An
+// erased slot becomes empty if its group has an empty slot, so no probe
+// ever passed through it, and a tombstone otherwise. The table rehashes
+// when the full slots and tombstones reach 7/8 of the capacity, at the same
+// capacity when at least half of them are tombstones. Keys are unique.
+// Rehashing and insertion invalidate every iterator, erase none but the
+// erased one.
+template <class Key, class Value, class HashFun, class ExtractKey, class EqualKey,
+		  class Alloc = type_allocator<Value> >
+class flat_hashtable
+{
+public:
+	typedef Key key_type;
+	typedef Value value_type;
+	typedef HashFun hasher;
+	typedef EqualKey key_equal;
+
+	typedef size_t            size_type;
+	typedef ptrdiff_t         difference_type;
+	typedef value_type*       pointer;
+	typedef const value_type* const_pointer;
+	typedef value_type&       reference;
+	typedef const value_type& const_reference;
+
+	typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+	typedef __flat_hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+	typedef Alloc allocator_type;
+
+private:
+	typedef typename Alloc::template rebind<__flat_ctrl>::other CtrlAllocator;
+
+	enum { __width = __flat_group::width };
+
+	hasher			m_hash;
+	key_equal		m_equal;
+	ExtractKey		m_get_key;
+	Alloc			m_alloc;
+	// m_capacity + 1 bytes, the last one is the sentinel
+	__flat_ctrl*	m_ctrl;
+	value_type*		m_slots;
+	// 0 or a power of two of at least one group
+	size_type		m_capacity;
+	size_type		m_size;
+	// empty slots that may still be filled before the next rehash
+	size_type		m_growth_left;
+
+	// the control bytes of a table without slots, only its sentinel is read
+	static __flat_ctrl* __empty_ctrl()
+	{
+		static __flat_ctrl ctrl[1] = { (__flat_ctrl)__flat_sentinel };
+		return ctrl;
+	}
+
+	static size_type __max_load(size_type capacity) { return capacity - capacity / 8; }
+
+	static size_type __capacity_for(size_type n)
+	{
+		size_type capacity = __width;
+		while (__max_load(capacity) < n)
+			capacity *= 2;
+		return capacity;
+	}
+
+	size_t __hash_key(const key_type& key) const { return __flat_mix(m_hash(key)); }
+	static __flat_ctrl __tag(size_t h) { return (__flat_ctrl)(h & 0x7F); }
+
+	iterator __iterator_at(size_type i) { return iterator(m_ctrl + i, m_slots + i); }
+	const_iterator __iterator_at(size_type i) const { return const_iterator(m_ctrl + i, m_slots + i); }
+
+	// the slot holding 'key', or m_capacity
+	size_type __find(const key_type& key, size_t h) const
+	{
+		if (m_capacity == 0)
+			return 0;
+		size_type group_mask = m_capacity / __width - 1;
+		size_type g = (h >> 7) & group_mask;
+		__flat_ctrl tag = __tag(h);
+		for (size_type step = 1; ; ++step)
+		{
+			__flat_group group(m_ctrl + g * __width);
+			for (unsigned m = group.__match(tag); m != 0; m &= m - 1)
+			{
+				size_type i = g * __width + __bit_scan_forward(m);
+				if (m_equal(m_get_key(m_slots[i]), key))
+					return i;
+			}
+			if (group.__match_empty() != 0)
+				return m_capacity;
+			// triangular steps visit every group when their number is a power of two
+			g = (g + step) & group_mask;
+		}
+	}
+
+	// the first empty or deleted slot on the probe sequence of 'h'
+	size_type __find_free(size_t h) const
+	{
+		size_type group_mask = m_capacity / __width - 1;
+		size_type g = (h >> 7) & group_mask;
+		for (size_type step = 1; ; ++step)
+		{
+			unsigned m = __flat_group(m_ctrl + g * __width).__match_free();
+			if (m != 0)
+				return g * __width + __bit_scan_forward(m);
+			g = (g + step) & group_mask;
+		}
+	}
+
+	void __set_ctrl_empty(size_type capacity)
+	{
+		memset(m_ctrl, (unsigned char)__flat_empty, capacity);
+		m_ctrl[capacity] = (__flat_ctrl)__flat_sentinel;
+	}
+
+	void __deallocate()
+	{
+		if (m_capacity != 0)
+		{
+			CtrlAllocator(m_alloc).deallocate(m_ctrl, m_capacity + 1);
+			m_alloc.deallocate(m_slots, m_capacity);
+		}
+	}
+
+	void __destroy_elements()
+	{
+		for (size_type i = 0; i < m_capacity; ++i)
+			if (m_ctrl[i] >= 0)
+				destruct(m_slots + i);
+	}
+
+	// moves the elements into new arrays of 'capacity' slots, dropping the
+	// tombstones; elements whose move may throw are copied, and if a copy
+	// throws the new arrays are dropped and the table is left as it was
+	void __rehash(size_type capacity)
+	{
+		__flat_ctrl* old_ctrl = m_ctrl;
+		value_type* old_slots = m_slots;
+		size_type old_capacity = m_capacity;
+		m_ctrl = CtrlAllocator(m_alloc).allocate(capacity + 1);
+		try
+		{
+			m_slots = m_alloc.allocate(capacity);
+		}
+		catch (...)
+		{
+			CtrlAllocator(m_alloc).deallocate(m_ctrl, capacity + 1);
+			m_ctrl = old_ctrl;
+			throw;
+		}
+		m_capacity = capacity;
+		__set_ctrl_empty(capacity);
+		try
+		{
+			for (size_type i = 0; i < old_capacity; ++i)
+			{
+				if (old_ctrl[i] < 0)
+					continue;
+				size_t h = __hash_key(m_get_key(old_slots[i]));
+				size_type j = __find_free(h);
+				construct(m_slots + j, MySTL::move_if_noexcept(old_slots[i]));
+				m_ctrl[j] = __tag(h);
+			}
+		}
+		catch (...)
+		{
+			__destroy_elements();
+			__deallocate();
+			m_ctrl = old_ctrl;
+			m_slots = old_slots;
+			m_capacity = old_capacity;
+			throw;
+		}
+		for (size_type i = 0; i < old_capacity; ++i)
+			if (old_ctrl[i] >= 0)
+				destruct(old_slots + i);
+		m_growth_left = __max_load(capacity) - m_size;
+		if (old_capacity != 0)
+		{
+			CtrlAllocator(m_alloc).deallocate(old_ctrl, old_capacity + 1);
+			m_alloc.deallocate(old_slots, old_capacity);
+		}
+	}
+
+	// makes room for one more element
+	void __grow()
+	{
+		if (m_capacity == 0)
+			__rehash(__width);
+		else if (m_size * 2 <= __max_load(m_capacity))
+			__rehash(m_capacity);	// mostly tombstones
+		else
+			__rehash(m_capacity * 2);
+	}
+
+	// a free slot for a new element with hash 'h', growing first when
+	// needed; a tombstone is reused without growing. The slot stays free
+	// until __commit_insert(), so a throwing constructor leaves no trace.
+	size_type __prepare_insert(size_t h)
+	{
+		if (m_capacity == 0)
+			__grow();
+		size_type i = __find_free(h);
+		if (m_growth_left == 0 && m_ctrl[i] != __flat_deleted)
+		{
+			__grow();
+			i = __find_free(h);
+		}
+		return i;
+	}
+
+	// the element in slot 'i' is constructed, it becomes visible
+	void __commit_insert(size_type i, size_t h)
+	{
+		if (m_ctrl[i] == __flat_empty)
+			--m_growth_left;
+		m_ctrl[i] = __tag(h);
+		++m_size;
+	}
+
+	void __copy_from(const flat_hashtable& ht)
+	{
+		if (ht.m_size == 0)
+			return;
+		m_ctrl = CtrlAllocator(m_alloc).allocate(ht.m_capacity + 1);
+		m_slots = m_alloc.allocate(ht.m_capacity);
+		m_capacity = ht.m_capacity;
+		memcpy(m_ctrl, ht.m_ctrl, m_capacity + 1);
+		for (size_type i = 0; i < m_capacity; ++i)
+			if (m_ctrl[i] >= 0)
+				construct(m_slots + i, ht.m_slots[i]);
+		m_size = ht.m_size;
+		m_growth_left = ht.m_growth_left;
+	}
+
+	void __initialize(size_type n)
+	{
+		m_ctrl = __empty_ctrl();
+		m_slots = 0;
+		m_capacity = 0;
+		m_size = 0;
+		m_growth_left = 0;
+		if (n != 0)
+			__rehash(__capacity_for(n));
+	}
+
+public:
+	explicit flat_hashtable(size_type n = 0)
+		: m_hash(HashFun()), m_equal(EqualKey()), m_get_key(ExtractKey())
+	{ __initialize(n); }
+
+	flat_hashtable(size_type n, const Alloc& a)
+		: m_hash(HashFun()), m_equal(EqualKey()), m_get_key(ExtractKey()), m_alloc(a)
+	{ __initialize(n); }
+
+	flat_hashtable(size_type n, const HashFun& hf, const EqualKey& eql, const ExtractKey& ext,
+				   const Alloc& a = Alloc())
+		: m_hash(hf), m_equal(eql), m_get_key(ext), m_alloc(a)
+	{ __initialize(n); }
+
+	flat_hashtable(size_type n, const HashFun& hf, const EqualKey& eql)
+		: m_hash(hf), m_equal(eql), m_get_key(ExtractKey())
+	{ __initialize(n); }
+
+	flat_hashtable(const flat_hashtable& ht)
+		: m_hash(ht.m_hash), m_equal(ht.m_equal), m_get_key(ht.m_get_key), m_alloc(ht.m_alloc)
+	{
+		__initialize(0);
+		__copy_from(ht);
+	}
+#if defined(__MYSTL_CXX11)
+	flat_hashtable(flat_hashtable&& ht)
+		: m_hash(ht.m_hash), m_equal(ht.m_equal), m_get_key(ht.m_get_key), m_alloc(ht.m_alloc)
+	{
+		__initialize(0);
+		swap(ht);
+	}
+#endif
+
+	flat_hashtable& operator=(const flat_hashtable& ht)
+	{
+		if (&ht != this)
+		{
+			flat_hashtable tmp(ht);
+			swap(tmp);
+		}
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	flat_hashtable& operator=(flat_hashtable&& ht)
+	{
+		swap(ht);
+		return *this;
+	}
+#endif
+
+	~flat_hashtable()
+	{
+		__destroy_elements();
+		__deallocate();
+	}
+
+	hasher hash_funct() const { return m_hash; }
+	key_equal key_eq() const { return m_equal; }
+	allocator_type get_allocator() const { return m_alloc; }
+
+	size_type size() const { return m_size; }
+	size_type max_size() const { return size_type(-1); }
+	bool empty() const { return m_size == 0; }
+
+	void swap(flat_hashtable& ht)
+	{
+		MySTL::swap(m_hash, ht.m_hash);
+		MySTL::swap(m_equal, ht.m_equal);
+		MySTL::swap(m_get_key, ht.m_get_key);
+		MySTL::swap(m_alloc, ht.m_alloc);
+		MySTL::swap(m_ctrl, ht.m_ctrl);
+		MySTL::swap(m_slots, ht.m_slots);
+		MySTL::swap(m_capacity, ht.m_capacity);
+		MySTL::swap(m_size, ht.m_size);
+		MySTL::swap(m_growth_left, ht.m_growth_left);
+	}
+
+	iterator begin()
+	{
+		iterator it(m_ctrl, m_slots);
+		it.__skip_free();
+		return it;
+	}
+	const_iterator begin() const
+	{
+		iterator it(m_ctrl, m_slots);
+		it.__skip_free();
+		return it;
+	}
+	iterator end() { return __iterator_at(m_capacity); }
+	const_iterator end() const { return __iterator_at(m_capacity); }
+
+	// slots, a multiple of the group width
+	size_type bucket_count() const { return m_capacity; }
+
+	pair<iterator, bool> insert_unique(const value_type& obj)
+	{
+		const key_type& key = m_get_key(obj);
+		size_t h = __hash_key(key);
+		size_type i = __find(key, h);
+		if (i != m_capacity)
+			return pair<iterator, bool>(__iterator_at(i), false);
+		i = __prepare_insert(h);
+		construct(m_slots + i, obj);
+		__commit_insert(i, h);
+		return pair<iterator, bool>(__iterator_at(i), true);
+	}
+
+	template <class InputIterator>
+	void insert_unique(InputIterator first, InputIterator last)
+	{
+		insert_unique(first, last, iterator_category(first));
+	}
+	template <class InputIterator>
+	void insert_unique(InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		for ( ; first != last; ++first)
+			insert_unique(*first);
+	}
+	template <class ForwardIterator>
+	void insert_unique(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = 0;
+		distance(first, last, n);
+		resize(m_size + n);
+		for ( ; first != last; ++first)
+			insert_unique(*first);
+	}
+
+	// the element with the key of 'obj', inserting 'obj' if there is none
+	reference find_or_insert(const value_type& obj)
+	{
+		return *insert_unique(obj).first;
+	}
+
+	iterator find(const key_type& key)
+	{
+		return __iterator_at(__find(key, __hash_key(key)));
+	}
+	const_iterator find(const key_type& key) const
+	{
+		return __iterator_at(__find(key, __hash_key(key)));
+	}
+
+	size_type count(const key_type& key) const
+	{
+		return __find(key, __hash_key(key)) != m_capacity ? 1 : 0;
+	}
+
+	pair<iterator, iterator> equal_range(const key_type& key)
+	{
+		iterator first = find(key);
+		iterator last = first;
+		if (first != end())
+			++last;
+		return pair<iterator, iterator>(first, last);
+	}
+
+	void erase(const iterator& it)
+	{
+		size_type i = it.m_slot - m_slots;
+		destruct(m_slots + i);
+		--m_size;
+		// a probe for any key stops at this group if it has an empty slot
+		// already, so the slot may become empty too
+		size_type g = i & ~size_type(__width - 1);
+		if (__flat_group(m_ctrl + g).__match_empty() != 0)
+		{
+			m_ctrl[i] = (__flat_ctrl)__flat_empty;
+			++m_growth_left;
+		}
+		else
+			m_ctrl[i] = (__flat_ctrl)__flat_deleted;
+	}
+
+	size_type erase(const key_type& key)
+	{
+		size_type i = __find(key, __hash_key(key));
+		if (i == m_capacity)
+			return 0;
+		erase(__iterator_at(i));
+		return 1;
+	}
+
+	void erase(iterator first, iterator last)
+	{
+		while (first != last)
+			erase(first++);
+	}
+
+	void clear()
+	{
+		if (m_capacity == 0)
+			return;
+		__destroy_elements();
+		__set_ctrl_empty(m_capacity);
+		m_size = 0;
+		m_growth_left = __max_load(m_capacity);
+	}
+
+	// room for 'num_elements_hint' elements without a rehash
+	void resize(size_type num_elements_hint)
+	{
+		size_type capacity = __capacity_for(num_elements_hint);
+		if (capacity > m_capacity)
+			__rehash(capacity);
+	}
+};
+
+// Unique associative containers on flat_hashtable. Iterators and
+// references are invalidated by every insertion that may rehash.
+template <class Key, class T, class HashFun = hash<Key>, class EqualKey = equal<Key>,
+		  class Alloc = type_allocator<pair<const Key, T> > >
+class hash_map
+{
+private:
+	typedef flat_hashtable<Key, pair<const Key, T>, HashFun,
+						   select1st<pair<const Key, T> >, EqualKey, Alloc> Table;
+	Table m_table;
+
+public:
+	typedef typename Table::key_type key_type;
+	typedef T data_type;
+	typedef T mapped_type;
+	typedef typename Table::value_type value_type;
+	typedef typename Table::hasher hasher;
+	typedef typename Table::key_equal key_equal;
+
+	typedef typename Table::size_type size_type;
+	typedef typename Table::difference_type difference_type;
+	typedef typename Table::pointer pointer;
+	typedef typename Table::const_pointer const_pointer;
+	typedef typename Table::reference reference;
+	typedef typename Table::const_reference const_reference;
+	typedef typename Table::iterator iterator;
+	typedef typename Table::const_iterator const_iterator;
+	typedef typename Table::allocator_type allocator_type;
+
+	hash_map() : m_table(0) {}
+	explicit hash_map(size_type n) : m_table(n) {}
+	hash_map(size_type n, const HashFun& hf) : m_table(n, hf, EqualKey()) {}
+	hash_map(size_type n, const HashFun& hf, const EqualKey& eql, const Alloc& a = Alloc())
+		: m_table(n, hf, eql, select1st<value_type>(), a) {}
+	template <class InputIterator>
+	hash_map(InputIterator first, InputIterator last, size_type n = 0) : m_table(n)
+	{ m_table.insert_unique(first, last); }
+
+	hasher hash_funct() const { return m_table.hash_funct(); }
+	key_equal key_eq() const { return m_table.key_eq(); }
+	allocator_type get_allocator() const { return m_table.get_allocator(); }
+
+	size_type size() const { return m_table.size(); }
+	size_type max_size() const { return m_table.max_size(); }
+	bool empty() const { return m_table.empty(); }
+	void swap(hash_map& hm) { m_table.swap(hm.m_table); }
+
+	iterator begin() { return m_table.begin(); }
+	iterator end() { return m_table.end(); }
+	const_iterator begin() const { return m_table.begin(); }
+	const_iterator end() const { return m_table.end(); }
+
+	pair<iterator, bool> insert(const value_type& obj) { return m_table.insert_unique(obj); }
+	template <class InputIterator>
+	void insert(InputIterator first, InputIterator last) { m_table.insert_unique(first, last); }
+
+	iterator find(const key_type& key) { return m_table.find(key); }
+	const_iterator find(const key_type& key) const { return m_table.find(key); }
+
+	// the element is built only for a new key
+	T& operator[](const key_type& key)
+	{
+		iterator it = m_table.find(key);
+		if (it == m_table.end())
+			it = m_table.insert_unique(value_type(key, T())).first;
+		return (*it).second;
+	}
+
+	size_type count(const key_type& key) const { return m_table.count(key); }
+	pair<iterator, iterator> equal_range(const key_type& key) { return m_table.equal_range(key); }
+
+	size_type erase(const key_type& key) { return m_table.erase(key); }
+	void erase(iterator it) { m_table.erase(it); }
+	void erase(iterator first, iterator last) { m_table.erase(first, last); }
+	void clear() { m_table.clear(); }
+
+	void resize(size_type hint) { m_table.resize(hint); }
+	size_type bucket_count() const { return m_table.bucket_count(); }
+};
+
+template <class Value, class HashFun = hash<Value>, class EqualKey = equal<Value>,
+		  class Alloc = type_allocator<Value> >
+class hash_set
+{
+private:
+	typedef flat_hashtable<Value, Value, HashFun, identity<Value>, EqualKey, Alloc> Table;
+	Table m_table;
+
+public:
+	typedef typename Table::key_type key_type;
+	typedef typename Table::value_type value_type;
+	typedef typename Table::hasher hasher;
+	typedef typename Table::key_equal key_equal;
+
+	typedef typename Table::size_type size_type;
+	typedef typename Table::difference_type difference_type;
+	typedef typename Table::const_pointer pointer;
+	typedef typename Table::const_pointer const_pointer;
+	typedef typename Table::const_reference reference;
+	typedef typename Table::const_reference const_reference;
+	// elements are keys, they may not be changed in place
+	typedef typename Table::const_iterator iterator;
+	typedef typename Table::const_iterator const_iterator;
+	typedef typename Table::allocator_type allocator_type;
+
+	hash_set() : m_table(0) {}
+	explicit hash_set(size_type n) : m_table(n) {}
+	hash_set(size_type n, const HashFun& hf) : m_table(n, hf, EqualKey()) {}
+	hash_set(size_type n, const HashFun& hf, const EqualKey& eql, const Alloc& a = Alloc())
+		: m_table(n, hf, eql, identity<Value>(), a) {}
+	template <class InputIterator>
+	hash_set(InputIterator first, InputIterator last, size_type n = 0) : m_table(n)
+	{ m_table.insert_unique(first, last); }
+
+	hasher hash_funct() const { return m_table.hash_funct(); }
+	key_equal key_eq() const { return m_table.key_eq(); }
+	allocator_type get_allocator() const { return m_table.get_allocator(); }
+
+	size_type size() const { return m_table.size(); }
+	size_type max_size() const { return m_table.max_size(); }
+	bool empty() const { return m_table.empty(); }
+	void swap(hash_set& hs) { m_table.swap(hs.m_table); }
+
+	iterator begin() const { return m_table.begin(); }
+	iterator end() const { return m_table.end(); }
+
+	pair<iterator, bool> insert(const value_type& obj)
+	{
+		pair<typename Table::iterator, bool> p = m_table.insert_unique(obj);
+		return pair<iterator, bool>(p.first, p.second);
+	}
+	template <class InputIterator>
+	void insert(InputIterator first, InputIterator last) { m_table.insert_unique(first, last); }
+
+	iterator find(const key_type& key) const { return m_table.find(key); }
+	size_type count(const key_type& key) const { return m_table.count(key); }
+
+	size_type erase(const key_type& key) { return m_table.erase(key); }
+	void erase(iterator it)
+	{
+		// the table erases through its mutable iterator
+		m_table.erase(typename Table::iterator(it.m_ctrl, it.m_slot));
+	}
+	void erase(iterator first, iterator last)
+	{
+		while (first != last)
+			erase(first++);
+	}
+	void clear() { m_table.clear(); }
+
+	void resize(size_type hint) { m_table.resize(hint); }
+	size_type bucket_count() const { return m_table.bucket_count(); }
+};
+
+__NS_END
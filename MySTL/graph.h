@@ -1,18 +1,28 @@
 #pragma once
 
 #include "vector.h"
+#include "small_vector.h"
+#include "dynamic_bitset.h"
 #include "slist.h"
 #include "queue.h"
+#include "circular_buffer.h"
 #include "index_priority_queue.h"
 #include "float.h"
 #include "union_find.h"
+#include "memory_resource.h"
 
 using MySTL::slist;
 using MySTL::vector;
+using MySTL::small_vector;
+using MySTL::dynamic_bitset;
 using MySTL::queue;
+using MySTL::circular_buffer;
 using MySTL::index_priority_queue;
 using MySTL::greater;
 using MySTL::priority_queue;
+using MySTL::memory_resource;
+using MySTL::unsynchronized_pool_resource;
+using MySTL::polymorphic_allocator;
 
 struct edge
 {
@@ -28,32 +38,62 @@ struct edge
 	}
 };
 
+// All storage of a graph (the list array, the lists and their edge nodes)
+// comes from one memory_resource. By default the graph owns a pool; pass a
+// monotonic_buffer_resource to build the graph in an arena and drop it all
+// with a single release().
 class graph
 {
 private:
-	typedef slist<edge> AdjacencyList;
-	typedef vector<AdjacencyList*> AdjacencyListArray;
+	typedef polymorphic_allocator<MySTL::__slist_node<edge> > EdgeAllocator;
+	typedef slist<edge, EdgeAllocator> AdjacencyList;
+	typedef polymorphic_allocator<AdjacencyList> ListAllocator;
+	typedef vector<AdjacencyList*, polymorphic_allocator<AdjacencyList*> > AdjacencyListArray;
+	unsynchronized_pool_resource m_pool;
+	memory_resource* m_resource;
 	int m_num_vertices;
 	int m_num_edges;
 	AdjacencyListArray m_adjacency_lists;
 	bool m_directed;
 
+	void __create_lists()
+	{
+		ListAllocator list_alloc(m_resource);
+		for (int i = 0; i < m_num_vertices; ++i)
+			m_adjacency_lists[i] = new (list_alloc.allocate()) AdjacencyList(EdgeAllocator(m_resource));
+	}
+
 public:
 	graph(int v, bool directed = false)
-		: m_num_vertices(v),
+		: m_resource(&m_pool),
+		  m_num_vertices(v),
 		  m_num_edges(0),
-		  m_adjacency_lists(v),
+		  m_adjacency_lists(v, (AdjacencyList*)0, m_resource),
 		  m_directed(directed)
 	{
-		for (int i = 0; i < v; ++i)
-			m_adjacency_lists[i] = new AdjacencyList;
+		__create_lists();
+	}
+	graph(int v, bool directed, memory_resource* resource)
+		: m_resource(resource),
+		  m_num_vertices(v),
+		  m_num_edges(0),
+		  m_adjacency_lists(v, (AdjacencyList*)0, m_resource),
+		  m_directed(directed)
+	{
+		__create_lists();
 	}
 	~graph()
 	{
+		ListAllocator list_alloc(m_resource);
 		for (int i = 0; i < m_num_vertices; ++i)
-			delete m_adjacency_lists[i];
+		{
+			m_adjacency_lists[i]->~AdjacencyList();
+			list_alloc.deallocate(m_adjacency_lists[i]);
+		}
 	}	
 
+	memory_resource* resource() const { return m_resource; }
+
 	int num_vertices() const { return m_num_vertices; }
 	int num_edges() const { return m_num_edges; }
 	void add_edge(int v, int w, float weight = 0.0f)
@@ -93,22 +133,19 @@ public:
 class Search
 {
 private:
-	bool* m_marked;
+	dynamic_bitset<> m_marked;
 	int m_count;
 	int *edge_to;
 	graph& m_graph;
 public:
 	Search(graph& m_graph) 
-		: m_graph(m_graph), m_count(0), m_marked(0)
+		: m_graph(m_graph), m_count(0), m_marked(m_graph.num_vertices())
 	{
-		m_marked = new bool[m_graph.num_vertices()];
-		for (int i = 0; i < m_graph.num_vertices(); ++i)
-			m_marked[i] = false;
 		edge_to = new int[m_graph.num_vertices()];
 		for (int i = 0; i < m_graph.num_vertices(); ++i)
 			edge_to[i] = -1;
 	}
-	~Search() { delete[] m_marked; delete[] edge_to;}
+	~Search() { delete[] edge_to;}
 
 	void DFS(int v)
 	{
@@ -127,7 +164,7 @@ public:
 
 	void BFS(int s)
 	{
-		queue<int> q;
+		queue<int, circular_buffer<int> > q;
 		m_marked[s] = true;
 		q.push(s);
 		while (!q.empty())
@@ -150,9 +187,12 @@ public:
 
 	bool marked(int v) { return m_marked[v]; }
 	int count() { return m_count; }
-	vector<int> path_to(int s, int v)
+	// most paths are short, they stay in the object
+	typedef small_vector<int, 16> Path;
+
+	Path path_to(int s, int v)
 	{
-		vector<int> path;
+		Path path;
 		if (marked(v))
 		{
 			for (int i = v; i != s; i = edge_to[i])
@@ -166,7 +206,7 @@ public:
 class PrimMST
 {
 private:
-	vector<bool> m_marked;
+	dynamic_bitset<> m_marked;
 	vector<float> m_dist_to;
 	vector<int> m_edge_to;
 	index_priority_queue<float, greater<float> > m_crossing_edge;
@@ -197,7 +237,7 @@ private:
 public:
 	PrimMST(graph& g)
 		: m_graph(g),
-		  m_marked(g.num_vertices(), false),
+		  m_marked(g.num_vertices()),
 		  m_dist_to(g.num_vertices(), FLT_MAX),
 		  m_edge_to(g.num_vertices(), -1),
 		  m_crossing_edge(g.num_vertices())
@@ -216,14 +256,14 @@ public:
 class KruskalMST
 {
 private:
-	vector<bool> m_marked;
+	dynamic_bitset<> m_marked;
 	vector<edge> m_mst_edge;
 	priority_queue<edge, vector<edge>, greater<edge> > m_edge_queue;
 	graph& m_graph;
 	UF m_uf;
 public:
 	KruskalMST(graph& g) 
-	: m_graph(g), m_marked(g.num_vertices(), false), m_uf(g.num_vertices()),
+	: m_graph(g), m_marked(g.num_vertices()), m_uf(g.num_vertices()),
 	  m_edge_queue(g.get_all_edge())
 	{
 		while (!m_edge_queue.empty() && m_mst_edge.size() < (size_t)g.num_vertices())
@@ -3,6 +3,7 @@
 #include "hash_function.h"
 #include "vector.h"
 #include "algorithm.h"
+#include "pool_allocator.h"
 
 __NS_BEGIN
 
@@ -14,7 +15,7 @@ struct __hashtable_node
 };
 
 template <class Key, class Value, class HashFun, 
-		  class ExtractKey, class EqualKey, class Alloc = type_allocator<__hashtable_node<Value> > >
+		  class ExtractKey, class EqualKey, class Alloc = type_allocator<__hashtable_node<Value>, pool_allocator> >
 class hashtable;
 
 template <class Key, class Value, class HashFun, 
@@ -96,6 +97,7 @@ public:
 
 	typedef __hashtable_node<Value> Node;
 	typedef __hashtable_iterator<Key,Value,HashFun,ExtractKey,EqualKey,Alloc> iterator;
+	typedef Alloc allocator_type;
 
 	friend struct __hashtable_iterator<Key,Value,HashFun,ExtractKey,EqualKey,Alloc>;
 
@@ -103,11 +105,15 @@ private:
 	hasher			m_hash;
 	key_equal		m_equal;
 	ExtractKey		m_get_key;
-	vector<Node*>	m_buckets;
+	Alloc			m_alloc;
+	// the bucket array comes from the same memory source as the nodes
+	typedef typename Alloc::template rebind<Node*>::other BucketAllocator;
+	typedef vector<Node*, BucketAllocator> BucketVector;
+	BucketVector	m_buckets;
 	size_type		m_num_elements;
 
-	Node* __get_node() { return Alloc::allocate(1); }
-	void __put_node(Node* p) { Alloc::deallocate(p, 1); }
+	Node* __get_node() { return m_alloc.allocate(1); }
+	void __put_node(Node* p) { m_alloc.deallocate(p, 1); }
 	Node* __new_node(const value_type& obj)
 	{
 		Node* n = __get_node();
@@ -126,8 +132,15 @@ public:
 		: m_hash(HashFun()), m_equal(EqualKey()), m_get_key(ExtractKey()), m_num_elements(0)
 	{ __initialize_buckets(n); }
 
-	hashtable(size_type n, const HashFun& hf, const EqualKey& eql, const ExtractKey& ext)
-		: m_hash(hf), m_equal(eql), m_get_key(ext), m_num_elements(0)
+	hashtable(size_type n, const Alloc& a)
+		: m_hash(HashFun()), m_equal(EqualKey()), m_get_key(ExtractKey()), 
+		  m_alloc(a), m_buckets(BucketAllocator(a)), m_num_elements(0)
+	{ __initialize_buckets(n); }
+
+	hashtable(size_type n, const HashFun& hf, const EqualKey& eql, const ExtractKey& ext, 
+			  const Alloc& a = Alloc())
+		: m_hash(hf), m_equal(eql), m_get_key(ext), 
+		  m_alloc(a), m_buckets(BucketAllocator(a)), m_num_elements(0)
 	{ __initialize_buckets(n); }
 
 	hashtable(size_type n, const HashFun& hf, const EqualKey& eql)
@@ -135,7 +148,8 @@ public:
 	{ __initialize_buckets(n); }
 
 	hashtable(const hashtable& ht)
-		: m_hash(ht.m_hash), m_equal(ht.m_equal), m_get_key(ht.m_get_key), m_num_elements(0)
+		: m_hash(ht.m_hash), m_equal(ht.m_equal), m_get_key(ht.m_get_key), 
+		  m_alloc(ht.m_alloc), m_buckets(ht.m_buckets.get_allocator()), m_num_elements(0)
 	{ __copy_from(ht); }
 
 	hashtable& operator= (const hashtable& ht)
@@ -155,6 +169,7 @@ public:
 
 	hasher hash_funct() const { return m_hash; }
 	key_equal key_eq() const { return m_equal; }
+	allocator_type get_allocator() const { return m_alloc; }
 
 	size_type size() const { return m_num_elements; }
 	size_type max_size() const { return size_type(-1); }
@@ -162,11 +177,12 @@ public:
 
 	void swap(hashtable& ht)
 	{
-		::swap(m_hash, ht.m_hash);
-		::swap(m_equal, ht.m_equal);
-		::swap(m_get_key, ht.m_get_key);
+		MySTL::swap(m_hash, ht.m_hash);
+		MySTL::swap(m_equal, ht.m_equal);
+		MySTL::swap(m_get_key, ht.m_get_key);
+		MySTL::swap(m_alloc, ht.m_alloc);
 		m_buckets.swap(ht.m_buckets);
-		::swap(m_num_elements, ht.m_num_elements);
+		MySTL::swap(m_num_elements, ht.m_num_elements);
 	}
 
 	iterator begin()
@@ -399,7 +415,7 @@ public:
 			size_type new_bkt_size = __next_size(num_elements_hint);
 			if (new_bkt_size > old_bucket_size)
 			{
-				vector<Node*> tmp(new_bkt_size, (Node*)0);
+				BucketVector tmp(new_bkt_size, (Node*)0, m_buckets.get_allocator());
 				for (size_type bucket = 0; bucket < old_bucket_size; ++bucket)
 				{
 					Node* first = m_buckets[bucket];
@@ -0,0 +1,527 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+
+__NS_BEGIN
+
+enum { __HIVE_NO_FREE = 0xFFFF, __HIVE_MIN_GROUP = 8, __HIVE_MAX_GROUP = 8192 };
+
+// a type with alignment N, so that slots are no wider than the element
+template <size_t N> struct __hive_align { typedef long double type; };
+template <> struct __hive_align<1> { typedef char type; };
+template <> struct __hive_align<2> { typedef short type; };
+template <> struct __hive_align<4> { typedef int type; };
+template <> struct __hive_align<8> { typedef long long type; };
+
+// storage of one element; an erased slot that starts a skipped run holds
+// the links of the run list of its group instead
+template <class T>
+union __hive_slot
+{
+	char m_bytes[sizeof(T)];
+	typename __hive_align<__MYSTL_ALIGNOF(T)>::type m_align;
+	struct
+	{
+		unsigned short m_prev;
+		unsigned short m_next;
+	} m_free;
+};
+
+// Block of slots. m_skip is a jump-counting skip field: 0 for a live slot,
+// and for a run of erased slots its length, stored at the first and at the
+// last slot of the run, so iteration steps over a whole run at once.
+template <class T>
+struct __hive_group
+{
+	__hive_slot<T>* m_slots;
+	unsigned short* m_skip;		// m_capacity + 1 entries, the last stays 0
+	__hive_group* m_next;
+	__hive_group* m_prev;
+	__hive_group* m_next_free;	// groups that have erased slots
+	__hive_group* m_prev_free;
+	unsigned short m_capacity;
+	unsigned short m_last;		// slots [0, m_last) have been used
+	unsigned short m_size;
+	unsigned short m_free_head;	// first slot of the first skipped run
+};
+
+template <class T, class Ref, class Ptr>
+struct __hive_iterator
+{
+	typedef bidirectional_iterator_tag category;
+	typedef T value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef ptrdiff_t difference_type;
+	typedef __hive_iterator<T, T&, T*> iterator;
+	typedef __hive_iterator<T, Ref, Ptr> Self;
+	typedef __hive_group<T> Group;
+
+	Group* m_group;
+	size_t m_index;
+
+	// a group is never left empty, so one jump always reaches an element
+	void m_incr()
+	{
+		++m_index;
+		m_index += m_group->m_skip[m_index];
+		if (m_index == m_group->m_capacity && m_group->m_next != 0)
+		{
+			m_group = m_group->m_next;
+			m_index = m_group->m_skip[0];
+		}
+	}
+	void m_decr()
+	{
+		if (m_index != 0)
+		{
+			size_t i = m_index - 1;
+			size_t skip = m_group->m_skip[i];
+			if (skip <= i)
+			{
+				m_index = i - skip;
+				return;
+			}
+		}
+		m_group = m_group->m_prev;
+		size_t i = m_group->m_capacity - 1;
+		m_index = i - m_group->m_skip[i];
+	}
+
+	__hive_iterator() : m_group(0), m_index(0) {}
+	__hive_iterator(Group* group, size_t index) : m_group(group), m_index(index) {}
+	__hive_iterator(const iterator& x) : m_group(x.m_group), m_index(x.m_index) {}
+
+	Ref operator*() const { return *(T*)m_group->m_slots[m_index].m_bytes; }
+	Ptr operator->() const { return &(operator*()); }
+	bool operator==(const Self& x) const { return m_group == x.m_group && m_index == x.m_index; }
+	bool operator!=(const Self& x) const { return !(*this == x); }
+	Self& operator++()
+	{
+		m_incr();
+		return *this;
+	}
+	Self operator++(int)
+	{
+		Self tmp = *this;
+		m_incr();
+		return tmp;
+	}
+	Self& operator--()
+	{
+		m_decr();
+		return *this;
+	}
+	Self operator--(int)
+	{
+		Self tmp = *this;
+		m_decr();
+		return tmp;
+	}
+};
+
+// Unordered container with stable element addresses, after plf::colony.
+// Elements live in blocks of growing size; erase only marks the slot in the
+// skip field and links it into a free list, and insert fills erased slots
+// before it appends. Pointers and iterators stay valid until their element
+// is erased, and iteration walks contiguous memory, jumping over erased
+// runs. A block is freed as soon as its last element is erased.
+template <class T, class Alloc = type_allocator<T> >
+class hive
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef Alloc allocator_type;
+
+	typedef __hive_iterator<T, T&, T*>             iterator;
+	typedef __hive_iterator<T, const T&, const T*> const_iterator;
+
+private:
+	typedef __hive_group<T> Group;
+	typedef __hive_slot<T> Slot;
+	typedef typename Alloc::template rebind<Group>::other GroupAllocator;
+	typedef typename Alloc::template rebind<Slot>::other SlotAllocator;
+	typedef typename Alloc::template rebind<unsigned short>::other SkipAllocator;
+
+	Group* m_begin_group;
+	Group* m_back_group;
+	Group* m_free_groups;
+	size_type m_size;
+	size_type m_capacity;
+	Alloc m_alloc;
+
+	void __initialize_empty()
+	{
+		m_begin_group = m_back_group = m_free_groups = 0;
+		m_size = m_capacity = 0;
+	}
+
+	static T* __element(Group* g, size_t index) { return (T*)g->m_slots[index].m_bytes; }
+
+	void __new_back_group(size_type capacity)
+	{
+		Group* g = GroupAllocator(m_alloc).allocate(1);
+		g->m_slots = SlotAllocator(m_alloc).allocate(capacity);
+		g->m_skip = SkipAllocator(m_alloc).allocate(capacity + 1);
+		memset(g->m_skip, 0, (capacity + 1) * sizeof(unsigned short));
+		g->m_next = 0;
+		g->m_prev = m_back_group;
+		g->m_next_free = g->m_prev_free = 0;
+		g->m_capacity = (unsigned short)capacity;
+		g->m_last = g->m_size = 0;
+		g->m_free_head = __HIVE_NO_FREE;
+		if (m_back_group)
+			m_back_group->m_next = g;
+		else
+			m_begin_group = g;
+		m_back_group = g;
+		m_capacity += capacity;
+	}
+
+	void __delete_group(Group* g)
+	{
+		m_capacity -= g->m_capacity;
+		SkipAllocator(m_alloc).deallocate(g->m_skip, g->m_capacity + 1);
+		SlotAllocator(m_alloc).deallocate(g->m_slots, g->m_capacity);
+		GroupAllocator(m_alloc).deallocate(g, 1);
+	}
+
+	// unlinks and frees a group without elements
+	void __remove_group(Group* g)
+	{
+		if (g->m_free_head != __HIVE_NO_FREE)
+			__unlink_free_group(g);
+		if (g->m_prev)
+			g->m_prev->m_next = g->m_next;
+		else
+			m_begin_group = g->m_next;
+		if (g->m_next)
+			g->m_next->m_prev = g->m_prev;
+		else
+			m_back_group = g->m_prev;
+		__delete_group(g);
+	}
+
+	void __unlink_free_group(Group* g)
+	{
+		if (g->m_prev_free)
+			g->m_prev_free->m_next_free = g->m_next_free;
+		else
+			m_free_groups = g->m_next_free;
+		if (g->m_next_free)
+			g->m_next_free->m_prev_free = g->m_prev_free;
+		g->m_next_free = g->m_prev_free = 0;
+	}
+
+	// puts the run starting at 'start' at the head of the run list of 'g'
+	void __link_run(Group* g, size_t start)
+	{
+		Slot& s = g->m_slots[start];
+		s.m_free.m_prev = __HIVE_NO_FREE;
+		s.m_free.m_next = g->m_free_head;
+		if (g->m_free_head != __HIVE_NO_FREE)
+			g->m_slots[g->m_free_head].m_free.m_prev = (unsigned short)start;
+		else
+		{
+			g->m_prev_free = 0;
+			g->m_next_free = m_free_groups;
+			if (m_free_groups)
+				m_free_groups->m_prev_free = g;
+			m_free_groups = g;
+		}
+		g->m_free_head = (unsigned short)start;
+	}
+
+	void __unlink_run(Group* g, size_t start)
+	{
+		Slot& s = g->m_slots[start];
+		if (s.m_free.m_prev != __HIVE_NO_FREE)
+			g->m_slots[s.m_free.m_prev].m_free.m_next = s.m_free.m_next;
+		else
+			g->m_free_head = s.m_free.m_next;
+		if (s.m_free.m_next != __HIVE_NO_FREE)
+			g->m_slots[s.m_free.m_next].m_free.m_prev = s.m_free.m_prev;
+		if (g->m_free_head == __HIVE_NO_FREE)
+			__unlink_free_group(g);
+	}
+
+	// the run that started at 'from' now starts at 'to'
+	void __move_run(Group* g, size_t from, size_t to)
+	{
+		Slot& s = g->m_slots[to];
+		s.m_free = g->m_slots[from].m_free;
+		if (s.m_free.m_prev != __HIVE_NO_FREE)
+			g->m_slots[s.m_free.m_prev].m_free.m_next = (unsigned short)to;
+		else
+			g->m_free_head = (unsigned short)to;
+		if (s.m_free.m_next != __HIVE_NO_FREE)
+			g->m_slots[s.m_free.m_next].m_free.m_prev = (unsigned short)to;
+	}
+
+	// picks the slot for a new element: the first slot of an erased run, else
+	// the end of the back group, else a new group; the slot counts as live
+	// afterwards
+	iterator __take_slot()
+	{
+		Group* g = m_free_groups;
+		size_t index;
+		if (g)
+		{
+			index = g->m_free_head;
+			size_t len = g->m_skip[index];
+			if (len == 1)
+				__unlink_run(g, index);
+			else
+			{
+				__move_run(g, index, index + 1);
+				g->m_skip[index + 1] = g->m_skip[index + len - 1] = (unsigned short)(len - 1);
+			}
+			g->m_skip[index] = 0;
+		}
+		else
+		{
+			if (m_back_group == 0 || m_back_group->m_last == m_back_group->m_capacity)
+				__new_back_group(MySTL::min(MySTL::max(m_size, (size_type)__HIVE_MIN_GROUP), (size_type)__HIVE_MAX_GROUP));
+			g = m_back_group;
+			index = g->m_last++;
+		}
+		++g->m_size;
+		++m_size;
+		return iterator(g, index);
+	}
+
+	// marks the slot of an erased element, merging it with its neighbour runs
+	void __release_slot(Group* g, size_t index)
+	{
+		unsigned short* skip = g->m_skip;
+		size_t left = index != 0 ? skip[index - 1] : 0;
+		size_t right = skip[index + 1];
+		if (left == 0 && right == 0)
+		{
+			skip[index] = 1;
+			__link_run(g, index);
+		}
+		else if (right == 0)
+			skip[index - left] = skip[index] = (unsigned short)(left + 1);
+		else if (left == 0)
+		{
+			__move_run(g, index + 1, index);
+			skip[index] = skip[index + right] = (unsigned short)(right + 1);
+		}
+		else
+		{
+			__unlink_run(g, index + 1);
+			skip[index - left] = skip[index + right] = (unsigned short)(left + right + 1);
+		}
+	}
+
+	// gives back a slot from __take_slot() whose element could not be
+	// constructed, as erase() does after destroying one
+	void __untake_slot(iterator it)
+	{
+		Group* g = it.m_group;
+		--m_size;
+		if (--g->m_size == 0)
+			__remove_group(g);
+		else
+			__release_slot(g, it.m_index);
+	}
+
+	template <class Integer>
+	void __insert_aux(Integer n, Integer x, true_type)
+	{
+		insert((size_type)n, (T)x);
+	}
+	template <class InputIterator>
+	void __insert_aux(InputIterator first, InputIterator last, false_type)
+	{
+		for ( ; first != last; ++first)
+			insert(*first);
+	}
+
+public:
+	hive() { __initialize_empty(); }
+	explicit hive(const Alloc& a) : m_alloc(a) { __initialize_empty(); }
+	hive(size_type n, const T& x, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__initialize_empty();
+		insert(n, x);
+	}
+	template <class InputIterator>
+	hive(InputIterator first, InputIterator last, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__initialize_empty();
+		insert(first, last);
+	}
+	hive(const hive<T, Alloc>& other)
+		: m_alloc(other.m_alloc)
+	{
+		__initialize_empty();
+		insert(other.begin(), other.end());
+	}
+#if defined(__MYSTL_CXX11)
+	hive(hive<T, Alloc>&& other)
+		: m_alloc(other.m_alloc)
+	{
+		__initialize_empty();
+		swap(other);
+	}
+#endif
+
+	~hive() { clear(); }
+
+	iterator begin() { return m_begin_group ? iterator(m_begin_group, m_begin_group->m_skip[0]) : iterator(); }
+	const_iterator begin() const { return const_cast<hive*>(this)->begin(); }
+	iterator end() { return m_back_group ? iterator(m_back_group, m_back_group->m_last) : iterator(); }
+	const_iterator end() const { return const_cast<hive*>(this)->end(); }
+	size_type size() const { return m_size; }
+	// slots in all groups, live or erased
+	size_type capacity() const { return m_capacity; }
+	bool empty() const { return m_size == 0; }
+	allocator_type get_allocator() const { return m_alloc; }
+
+	iterator insert(const T& x)
+	{
+		iterator it = __take_slot();
+		try
+		{
+			construct(&*it, x);
+		}
+		catch (...)
+		{
+			__untake_slot(it);
+			throw;
+		}
+		return it;
+	}
+	void insert(size_type n, const T& x)
+	{
+		for ( ; n > 0; --n)
+			insert(x);
+	}
+	template <class InputIterator>
+	void insert(InputIterator first, InputIterator last)
+	{
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__insert_aux(first, last, is_int());
+	}
+#if defined(__MYSTL_CXX11)
+	template <class... Args>
+	iterator emplace(Args&&... args)
+	{
+		iterator it = __take_slot();
+		try
+		{
+			construct(&*it, MySTL::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			__untake_slot(it);
+			throw;
+		}
+		return it;
+	}
+#endif
+
+	iterator erase(const_iterator pos)
+	{
+		Group* g = pos.m_group;
+		size_t index = pos.m_index;
+		iterator next(g, index);
+		++next;
+		destruct(__element(g, index));
+		--m_size;
+		if (--g->m_size == 0)
+		{
+			__remove_group(g);
+			return next.m_group == g ? end() : next;
+		}
+		__release_slot(g, index);
+		return next;
+	}
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		if (last == end())
+		{
+			while (first != end())
+				first = erase(first);
+			return end();
+		}
+		while (first != last)
+			first = erase(first);
+		return iterator(last.m_group, last.m_index);
+	}
+
+	void clear()
+	{
+		range_destruct(begin(), end());
+		Group* g = m_begin_group;
+		while (g)
+		{
+			Group* next = g->m_next;
+			__delete_group(g);
+			g = next;
+		}
+		__initialize_empty();
+	}
+
+	// iterator to the element at 'p', which must be in this hive
+	iterator get_iterator(const T* p)
+	{
+		for (Group* g = m_begin_group; g; g = g->m_next)
+		{
+			const Slot* s = (const Slot*)p;
+			if (s >= g->m_slots && s < g->m_slots + g->m_capacity)
+				return iterator(g, s - g->m_slots);
+		}
+		return end();
+	}
+
+	hive<T, Alloc>& operator=(const hive<T, Alloc>& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			insert(other.begin(), other.end());
+		}
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	hive<T, Alloc>& operator=(hive<T, Alloc>&& other)
+	{
+		swap(other);
+		return *this;
+	}
+#endif
+
+	void swap(hive<T, Alloc>& other)
+	{
+		MySTL::swap(m_begin_group, other.m_begin_group);
+		MySTL::swap(m_back_group, other.m_back_group);
+		MySTL::swap(m_free_groups, other.m_free_groups);
+		MySTL::swap(m_size, other.m_size);
+		MySTL::swap(m_capacity, other.m_capacity);
+		MySTL::swap(m_alloc, other.m_alloc);
+	}
+};
+
+// the groups live on the heap and do not point back
+template <class T, class Alloc>
+struct is_trivially_relocatable<hive<T, Alloc> >
+{
+	typedef true_type type;
+};
+
+__NS_END
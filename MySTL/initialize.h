@@ -7,6 +7,13 @@
 
 __NS_BEGIN
 
+#if defined(__MYSTL_CXX11)
+template <class T, class... Args>
+void construct(T* p, Args&&... args)
+{
+	new (p) T(MySTL::forward<Args>(args)...);
+}
+#else
 template <class T1, class T2>
 void construct(T1* p, const T2& v)
 {
@@ -18,17 +25,28 @@ void construct(T* p)
 {
 	new (p) T();
 }
+#endif
+
+template <class ForwardIterator>
+void range_destruct(ForwardIterator first, ForwardIterator last);
 
+// the constructors of non-POD elements commit or roll back: if one throws,
+// the elements built so far are destroyed again before it propagates
 template <class ForwardIterator, class InputIterator>
 ForwardIterator range_construct_aux(InputIterator first, InputIterator last, ForwardIterator result, false_type)
 {
-	while (first != last)
+	ForwardIterator cur = result;
+	try
 	{
-		construct(&*result, *first);
-		++result;
-		++first;
+		for ( ; first != last; ++first, ++cur)
+			construct(&*cur, *first);
 	}
-	return result;
+	catch (...)
+	{
+		range_destruct(result, cur);
+		throw;
+	}
+	return cur;
 }
 
 template <class ForwardIterator, class InputIterator>
@@ -46,13 +64,51 @@ ForwardIterator range_construct(InputIterator first, InputIterator last, Forward
 	return range_construct_aux(first, last, result, is_POD_type());		
 }
 
+template <class ForwardIterator, class InputIterator>
+ForwardIterator range_move_construct_aux(InputIterator first, InputIterator last, ForwardIterator result, false_type)
+{
+	ForwardIterator cur = result;
+	try
+	{
+		for ( ; first != last; ++first, ++cur)
+			construct(&*cur, MySTL::move_if_noexcept(*first));
+	}
+	catch (...)
+	{
+		range_destruct(result, cur);
+		throw;
+	}
+	return cur;
+}
+
+template <class ForwardIterator, class InputIterator>
+ForwardIterator range_move_construct_aux(InputIterator first, InputIterator last, ForwardIterator result, true_type)
+{
+	return MySTL::copy(first, last, result);
+}
+
+// like range_construct, but moves the elements when that cannot throw
+template <class ForwardIterator, class InputIterator>
+ForwardIterator range_move_construct(InputIterator first, InputIterator last, ForwardIterator result)
+{
+	typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+	typedef typename type_traits<value_type>::is_POD_type is_POD_type;
+	return range_move_construct_aux(first, last, result, is_POD_type());
+}
+
 template <class ForwardIterator, class Tp>
 void fill_construct_aux(ForwardIterator first, ForwardIterator last, const Tp& value, false_type)
 {
-	while (first != last)
+	ForwardIterator cur = first;
+	try
 	{
-		construct(&*first, value);
-		++first;
+		for ( ; cur != last; ++cur)
+			construct(&*cur, value);
+	}
+	catch (...)
+	{
+		range_destruct(first, cur);
+		throw;
 	}
 }
 
@@ -74,12 +130,18 @@ void fill_construct(ForwardIterator first, ForwardIterator last, const Tp& value
 template <class ForwardIterator, class Tp, class Size>
 ForwardIterator fill_construct_n_aux(ForwardIterator result, Size n, const Tp& value, false_type)
 {
-	while (n-- > 0)
+	ForwardIterator cur = result;
+	try
 	{
-		construct(&*result, value);
-		++result;
+		for ( ; n > 0; --n, ++cur)
+			construct(&*cur, value);
 	}
-	return result;
+	catch (...)
+	{
+		range_destruct(result, cur);
+		throw;
+	}
+	return cur;
 }
 
 template <class ForwardIterator, class Tp, class Size>
@@ -125,4 +187,41 @@ void range_destruct(ForwardIterator first, ForwardIterator last)
 	range_destruct_aux(first, last, has_trivial_destructor());
 }
 
+// Opens a gap of 'n' raw slots at 'pos' for an insertion into trivially
+// relocatable elements by moving [pos, finish) up bitwise. The caller
+// constructs the new elements in the gap and calls __fill(), which moves
+// 'finish' past them; if a constructor throws first, the destructor moves
+// the tail back down and the sequence is as it was.
+template <class T>
+class __relocation_gap
+{
+public:
+	__relocation_gap(T* pos, size_t n, T*& finish)
+		: m_pos(pos), m_n(n), m_finish(finish), m_filled(false)
+	{
+		if (pos != finish)
+			memmove((void*)(pos + n), (void*)pos, (finish - pos) * sizeof(T));
+	}
+	~__relocation_gap()
+	{
+		if (!m_filled && m_pos != m_finish)
+			memmove((void*)m_pos, (void*)(m_pos + m_n), (m_finish - m_pos) * sizeof(T));
+	}
+
+	void __fill()
+	{
+		m_finish += m_n;
+		m_filled = true;
+	}
+
+private:
+	T* m_pos;
+	size_t m_n;
+	T*& m_finish;
+	bool m_filled;
+
+	__relocation_gap(const __relocation_gap&);
+	void operator=(const __relocation_gap&);
+};
+
 __NS_END
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include "algo_base.h"
+#include "initialize.h"
+#include "type_traits.h"
+
+__NS_BEGIN
+
+// vector with a fixed capacity of N elements stored inside the object, it
+// never allocates. Growing past N throws bad_alloc, try_push_back reports
+// it instead. push_front and pop_front shift the elements, they are there
+// so that a small bounded queue<> can use it. The buffer has malloc
+// alignment, so T must not be over-aligned. N must be at least 1.
+template <class T, size_t N>
+class inplace_vector
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+private:
+	union __inline_buffer
+	{
+		char m_bytes[N * sizeof(T)];
+		double m_align_double;
+		long double m_align_long_double;
+		void* m_align_pointer;
+	};
+
+	size_type m_size;
+	__inline_buffer m_buffer;
+
+	T* __start() { return (T*)m_buffer.m_bytes; }
+	const T* __start() const { return (const T*)m_buffer.m_bytes; }
+
+	void __check_room(size_type n) const
+	{
+		if (N - m_size < n)
+			throw std::bad_alloc();
+	}
+
+	// 'x' is a local copy, no element of this vector
+	void __insert_value(iterator pos, T& x)
+	{
+		__check_room(1);
+		iterator finish = end();
+		if (pos == finish)
+			construct(finish, MySTL::move(x));
+		else
+		{
+			construct(finish, MySTL::move(*(finish - 1)));
+			MySTL::move_backward(pos, finish - 1, finish);
+			*pos = MySTL::move(x);
+		}
+		++m_size;
+	}
+
+	void __fill_insert(iterator pos, size_type n, const T& x)
+	{
+		if (n == 0)
+			return;
+		__check_room(n);
+		T x_copy = x;
+		iterator finish = end();
+		size_type elems_after = finish - pos;
+		if (elems_after >= n)
+		{
+			range_move_construct(finish - n, finish, finish);
+			MySTL::move_backward(pos, finish - n, finish);
+			MySTL::fill_n(pos, n, x_copy);
+		}
+		else
+		{
+			iterator new_finish = fill_construct_n(finish, n - elems_after, x_copy);
+			range_move_construct(pos, finish, new_finish);
+			MySTL::fill_n(pos, elems_after, x_copy);
+		}
+		m_size += n;
+	}
+
+	template <class InputIterator>
+	void __range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		for ( ; first != last; ++first, ++pos)
+			insert(pos, *first);
+	}
+	template <class ForwardIterator>
+	void __range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		if (first == last)
+			return;
+		size_type n = MySTL::distance(first, last);
+		__check_room(n);
+		iterator finish = end();
+		size_type elems_after = finish - pos;
+		if (elems_after >= n)
+		{
+			range_move_construct(finish - n, finish, finish);
+			MySTL::move_backward(pos, finish - n, finish);
+			MySTL::copy(first, last, pos);
+		}
+		else
+		{
+			ForwardIterator mid = first;
+			MySTL::advance(mid, elems_after);
+			iterator new_finish = range_construct(mid, last, finish);
+			range_move_construct(pos, finish, new_finish);
+			MySTL::copy(first, mid, pos);
+		}
+		m_size += n;
+	}
+	template <class Integer>
+	void __insert_aux(iterator pos, Integer n, Integer x, true_type)
+	{
+		__fill_insert(pos, n, x);
+	}
+	template <class InputIterator>
+	void __insert_aux(iterator pos, InputIterator first, InputIterator last, false_type)
+	{
+		__range_insert(pos, first, last, iterator_category(first));
+	}
+
+public:
+	inplace_vector() : m_size(0) {}
+	inplace_vector(size_type n, const T& x)
+		: m_size(0)
+	{
+		__fill_insert(end(), n, x);
+	}
+	// the elements are value-initialized in place, T need not be copyable
+	explicit inplace_vector(size_type n)
+		: m_size(0)
+	{
+		resize(n);
+	}
+	template <class InputIterator>
+	inplace_vector(InputIterator first, InputIterator last)
+		: m_size(0)
+	{
+		insert(end(), first, last);
+	}
+	inplace_vector(const inplace_vector<T, N>& other)
+		: m_size(0)
+	{
+		insert(end(), other.begin(), other.end());
+	}
+#if defined(__MYSTL_CXX11)
+	// the elements are moved one by one, 'other' is left empty
+	inplace_vector(inplace_vector<T, N>&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+		: m_size(0)
+	{
+		__move_from(other);
+	}
+#endif
+
+	~inplace_vector() { range_destruct(begin(), end()); }
+
+	iterator begin() { return __start(); }
+	const_iterator begin() const { return __start(); }
+	iterator end() { return __start() + m_size; }
+	const_iterator end() const { return __start() + m_size; }
+	size_type size() const { return m_size; }
+	size_type capacity() const { return N; }
+	size_type max_size() const { return N; }
+	bool empty() const { return m_size == 0; }
+	bool full() const { return m_size == N; }
+	reference front() { return *begin(); }
+	const_reference front() const { return *begin(); }
+	reference back() { return *(end() - 1); }
+	const_reference back() const { return *(end() - 1); }
+
+	T& operator[](size_type index) { return __start()[index]; }
+	const T& operator[](size_type index) const { return __start()[index]; }
+
+	void push_back(const T& x)
+	{
+		__check_room(1);
+		construct(end(), x);
+		++m_size;
+	}
+	// false and no change when the vector is full
+	bool try_push_back(const T& x)
+	{
+		if (m_size == N)
+			return false;
+		construct(end(), x);
+		++m_size;
+		return true;
+	}
+	void insert(iterator pos, const T& x)
+	{
+		T x_copy = x;
+		__insert_value(pos, x_copy);
+	}
+	void push_front(const T& x) { insert(begin(), x); }
+	void insert(iterator pos, size_type n, const T& x) { __fill_insert(pos, n, x); }
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last)
+	{
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__insert_aux(pos, first, last, is_int());
+	}
+
+#if defined(__MYSTL_CXX11)
+	void insert(iterator pos, T&& x)
+	{
+		T x_copy(MySTL::move(x));
+		__insert_value(pos, x_copy);
+	}
+	void push_back(T&& x) { emplace_back(MySTL::move(x)); }
+	template <class... Args>
+	iterator emplace(iterator pos, Args&&... args)
+	{
+		T x(MySTL::forward<Args>(args)...);
+		__insert_value(pos, x);
+		return pos;
+	}
+	template <class... Args>
+	void emplace_back(Args&&... args)
+	{
+		__check_room(1);
+		construct(end(), MySTL::forward<Args>(args)...);
+		++m_size;
+	}
+#endif
+
+	iterator erase(iterator pos)
+	{
+		MySTL::move(pos + 1, end(), pos);
+		--m_size;
+		destruct(end());
+		return pos;
+	}
+	iterator erase(iterator first, iterator last)
+	{
+		iterator new_finish = MySTL::move(last, end(), first);
+		range_destruct(new_finish, end());
+		m_size = new_finish - begin();
+		return first;
+	}
+	void pop_back()
+	{
+		--m_size;
+		destruct(end());
+	}
+	void pop_front() { erase(begin()); }
+	void clear() { erase(begin(), end()); }
+
+	void resize(size_type new_sz, const T& x)
+	{
+		if (new_sz > size())
+			__fill_insert(end(), new_sz - size(), x);
+		else
+			erase(begin() + new_sz, end());
+	}
+	void resize(size_type new_sz)
+	{
+		if (new_sz > size())
+		{
+			__check_room(new_sz - size());
+			for ( ; m_size < new_sz; ++m_size)
+				construct(end());
+		}
+		else
+			erase(begin() + new_sz, end());
+	}
+	// the capacity is fixed, only checks that 'n' elements fit
+	void reserve(size_type n) { __check_room(n > m_size ? n - m_size : 0); }
+
+	void assign(size_type n, const T& x)
+	{
+		clear();
+		__fill_insert(end(), n, x);
+	}
+	template <class InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		insert(end(), first, last);
+	}
+	inplace_vector<T, N>& operator=(const inplace_vector<T, N>& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	inplace_vector<T, N>& operator=(inplace_vector<T, N>&& other)
+		noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &other)
+		{
+			clear();
+			__move_from(other);
+		}
+		return *this;
+	}
+#endif
+
+	void swap(inplace_vector<T, N>& other)
+	{
+		inplace_vector<T, N>& longer = size() >= other.size() ? *this : other;
+		inplace_vector<T, N>& shorter = size() >= other.size() ? other : *this;
+		size_type common = shorter.size();
+		for (size_type i = 0; i < common; ++i)
+			MySTL::swap((*this)[i], other[i]);
+		for (iterator i = longer.begin() + common; i != longer.end(); ++i)
+		{
+			construct(shorter.end(), MySTL::move(*i));
+			++shorter.m_size;
+		}
+		longer.erase(longer.begin() + common, longer.end());
+	}
+
+private:
+#if defined(__MYSTL_CXX11)
+	// this vector is empty
+	void __move_from(inplace_vector<T, N>& other)
+	{
+		range_move_construct(other.begin(), other.end(), begin());
+		m_size = other.m_size;
+		other.clear();
+	}
+#endif
+};
+
+// the elements are part of the object
+template <class T, size_t N>
+struct is_trivially_relocatable<inplace_vector<T, N> >
+{
+	typedef typename is_trivially_relocatable<T>::type type;
+};
+
+__NS_END
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <stdio.h>
+#include "config.h"
+#include "allocator.h"
+#include "vector.h"
+
+__NS_BEGIN
+
+// histogram bin k counts requests of (2^(k-1), 2^k] bytes, the last bin
+// takes everything larger
+enum { __ALLOC_HISTOGRAM_BINS = 32 };
+
+struct allocation_stats
+{
+	const char* m_name;
+	size_t m_allocations;
+	size_t m_deallocations;
+	size_t m_reallocations;
+	size_t m_total_bytes;
+	size_t m_live_bytes;
+	size_t m_peak_bytes;
+	size_t m_histogram[__ALLOC_HISTOGRAM_BINS];
+};
+
+struct __allocation_record
+{
+	allocation_stats m_stats;
+	__allocation_record* m_next;
+
+	explicit __allocation_record(const char* name);
+
+	static size_t __histogram_bin(size_t n)
+	{
+		size_t bin = 0;
+		for (size_t size = 1; size < n && bin < __ALLOC_HISTOGRAM_BINS - 1; size <<= 1)
+			++bin;
+		return bin;
+	}
+
+	void __reset()
+	{
+		m_stats.m_allocations = 0;
+		m_stats.m_deallocations = 0;
+		m_stats.m_reallocations = 0;
+		m_stats.m_total_bytes = 0;
+		m_stats.m_live_bytes = 0;
+		m_stats.m_peak_bytes = 0;
+		for (int i = 0; i < __ALLOC_HISTOGRAM_BINS; ++i)
+			m_stats.m_histogram[i] = 0;
+	}
+
+	void __on_allocate(size_t n)
+	{
+		++m_stats.m_allocations;
+		m_stats.m_total_bytes += n;
+		m_stats.m_live_bytes += n;
+		if (m_stats.m_live_bytes > m_stats.m_peak_bytes)
+			m_stats.m_peak_bytes = m_stats.m_live_bytes;
+		++m_stats.m_histogram[__histogram_bin(n)];
+	}
+
+	void __on_deallocate(size_t n)
+	{
+		++m_stats.m_deallocations;
+		m_stats.m_live_bytes -= n;
+	}
+
+	// a block resized from 'old_n' to 'new_n' bytes, moved or not
+	void __on_reallocate(size_t old_n, size_t new_n)
+	{
+		++m_stats.m_reallocations;
+		m_stats.m_total_bytes += new_n;
+		m_stats.m_live_bytes += new_n - old_n;
+		if (m_stats.m_live_bytes > m_stats.m_peak_bytes)
+			m_stats.m_peak_bytes = m_stats.m_live_bytes;
+		++m_stats.m_histogram[__histogram_bin(new_n)];
+	}
+};
+
+// every tag that has allocated at least once, most recent first
+inline __allocation_record*& __allocation_records()
+{
+	static __allocation_record* head = 0;
+	return head;
+}
+
+inline __allocation_record::__allocation_record(const char* name)
+	: m_next(__allocation_records())
+{
+	m_stats.m_name = name;
+	__reset();
+	__allocation_records() = this;
+}
+
+// Counting wrapper around a raw allocator ('allocator', pool_allocator, ...)
+// with the same static interface, so it can be used as the Alloc of
+// type_allocator or deque. Statistics are kept per Tag, Tag::name() labels
+// them in the report. Not thread safe.
+template <class Tag, class Alloc = allocator>
+class instrumented_allocator
+{
+public:
+	static void* allocate(size_t n)
+	{
+		void* p = Alloc::allocate(n);
+		if (p)
+			__record().__on_allocate(n);
+		return p;
+	}
+
+	// every block counts as an allocation, they are freed one by one
+	static void* allocate_chain(size_t n, size_t count)
+	{
+		void* p = Alloc::allocate_chain(n, count);
+		for (size_t i = 0; i < count; ++i)
+			__record().__on_allocate(n);
+		return p;
+	}
+
+	static void deallocate(void* p, size_t n)
+	{
+		if (p)
+			__record().__on_deallocate(n);
+		Alloc::deallocate(p, n);
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n)
+	{
+		if (p == 0)
+			return allocate(new_n);
+		void* q = Alloc::reallocate(p, old_n, new_n);
+		__record().__on_reallocate(old_n, new_n);
+		return q;
+	}
+
+	// over-aligned blocks, counted like the others
+	static void* allocate(size_t n, size_t align)
+	{
+		void* p = Alloc::allocate(n, align);
+		if (p)
+			__record().__on_allocate(n);
+		return p;
+	}
+
+	static void deallocate(void* p, size_t n, size_t align)
+	{
+		if (p)
+			__record().__on_deallocate(n);
+		Alloc::deallocate(p, n, align);
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n, size_t align)
+	{
+		if (p == 0)
+			return allocate(new_n, align);
+		void* q = Alloc::reallocate(p, old_n, new_n, align);
+		__record().__on_reallocate(old_n, new_n);
+		return q;
+	}
+
+	static bool try_expand_in_place(void* p, size_t old_n, size_t new_n)
+	{
+		if (!Alloc::try_expand_in_place(p, old_n, new_n))
+			return false;
+		__record().__on_reallocate(old_n, new_n);
+		return true;
+	}
+
+	static const allocation_stats& stats() { return __record().m_stats; }
+
+private:
+	static __allocation_record& __record()
+	{
+		static __allocation_record record(Tag::name());
+		return record;
+	}
+};
+
+struct vector_alloc_tag { static const char* name() { return "vector"; } };
+struct list_alloc_tag { static const char* name() { return "list"; } };
+struct slist_alloc_tag { static const char* name() { return "slist"; } };
+struct deque_alloc_tag { static const char* name() { return "deque"; } };
+struct hashtable_alloc_tag { static const char* name() { return "hashtable"; } };
+struct rb_tree_alloc_tag { static const char* name() { return "RB_tree"; } };
+struct avl_tree_alloc_tag { static const char* name() { return "AVL_tree"; } };
+
+// copies the current statistics of every tag
+inline vector<allocation_stats> allocation_snapshot()
+{
+	vector<allocation_stats> result;
+	for (__allocation_record* r = __allocation_records(); r; r = r->m_next)
+		result.push_back(r->m_stats);
+	return result;
+}
+
+inline void reset_allocation_stats()
+{
+	for (__allocation_record* r = __allocation_records(); r; r = r->m_next)
+		r->__reset();
+}
+
+inline void print_allocation_stats(FILE* out, const allocation_stats& s)
+{
+	fprintf(out, "%-12s allocs %10lu  frees %10lu  reallocs %10lu  total %12lu  live %12lu  peak %12lu\n",
+		s.m_name, (unsigned long)s.m_allocations, (unsigned long)s.m_deallocations, (unsigned long)s.m_reallocations,
+		(unsigned long)s.m_total_bytes, (unsigned long)s.m_live_bytes, (unsigned long)s.m_peak_bytes);
+	for (int bin = 0; bin < __ALLOC_HISTOGRAM_BINS; ++bin)
+	{
+		if (s.m_histogram[bin] == 0)
+			continue;
+		if (bin == __ALLOC_HISTOGRAM_BINS - 1)
+			fprintf(out, "%14s > %lu : %lu\n", "", 1ul << (bin - 1), (unsigned long)s.m_histogram[bin]);
+		else
+			fprintf(out, "%14s <= %lu : %lu\n", "", 1ul << bin, (unsigned long)s.m_histogram[bin]);
+	}
+}
+
+inline void print_allocation_report(FILE* out = stdout)
+{
+	vector<allocation_stats> snapshot = allocation_snapshot();
+	fprintf(out, "memory profile:\n");
+	for (size_t i = 0; i < snapshot.size(); ++i)
+		print_allocation_stats(out, snapshot[i]);
+}
+
+__NS_END
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <stddef.h>
+#include "algo_base.h"
+#include "functor.h"
+#include "slist.h"
+#include "list.h"
+
+__NS_BEGIN
+
+// Intrusive lists chain objects the caller already owns through a hook
+// stored in the object, as a base class or as a member. Nothing is
+// allocated, copied or destroyed: insert links the object, erase unlinks
+// it. An object must outlive its membership and may be in one list per
+// hook. list_hook::is_linked() tells whether the object is in a list.
+
+struct list_hook
+{
+	list_hook* m_next;
+	list_hook* m_prev;
+
+	list_hook() : m_next(0), m_prev(0) {}
+	// a copied object is not in the original's list
+	list_hook(const list_hook&) : m_next(0), m_prev(0) {}
+	list_hook& operator=(const list_hook&) { return *this; }
+
+	bool is_linked() const { return m_next != 0; }
+};
+
+struct slist_hook
+{
+	slist_hook* m_next;
+
+	slist_hook() : m_next(0) {}
+	slist_hook(const slist_hook&) : m_next(0) {}
+	slist_hook& operator=(const slist_hook&) { return *this; }
+};
+
+// T derives from Hook
+template <class T, class Hook>
+struct base_hook
+{
+	typedef Hook hook_type;
+
+	static Hook* to_hook(T* p) { return static_cast<Hook*>(p); }
+	static T* to_value(Hook* h) { return static_cast<T*>(h); }
+};
+
+// the hook is the member 'Member' of T
+template <class T, class Hook, Hook T::*Member>
+struct member_hook
+{
+	typedef Hook hook_type;
+
+	static Hook* to_hook(T* p) { return &(p->*Member); }
+	static T* to_value(Hook* h)
+	{
+		// offset of the member, taken on a dummy address rather than null
+		T* probe = (T*)0x1000;
+		size_t offset = (char*)&(probe->*Member) - (char*)probe;
+		return (T*)((char*)h - offset);
+	}
+};
+
+// orders hooks by the objects that hold them
+template <class HookAccess, class T, class Compare>
+struct __hook_compare
+{
+	typedef typename HookAccess::hook_type Hook;
+
+	Compare m_comp;
+
+	explicit __hook_compare(const Compare& comp) : m_comp(comp) {}
+	bool operator()(Hook* a, Hook* b) const
+	{
+		return m_comp(*HookAccess::to_value(a), *HookAccess::to_value(b));
+	}
+};
+
+template <class T, class Ref, class Ptr, class HookAccess>
+struct __intrusive_list_iterator
+{
+	typedef bidirectional_iterator_tag category;
+	typedef T value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef ptrdiff_t difference_type;
+	typedef __intrusive_list_iterator<T, Ref, Ptr, HookAccess> Self;
+	typedef __intrusive_list_iterator<T, T&, T*, HookAccess> iterator;
+
+	list_hook* m_node;
+
+	__intrusive_list_iterator(list_hook* node = 0) : m_node(node) {}
+	__intrusive_list_iterator(const iterator& x) : m_node(x.m_node) {}
+
+	reference operator*() const { return *HookAccess::to_value(m_node); }
+	pointer operator->() const { return HookAccess::to_value(m_node); }
+	bool operator==(const Self& x) const { return m_node == x.m_node; }
+	bool operator!=(const Self& x) const { return m_node != x.m_node; }
+	Self& operator++() { m_node = m_node->m_next; return *this; }
+	Self operator++(int) { Self tmp = *this; m_node = m_node->m_next; return tmp; }
+	Self& operator--() { m_node = m_node->m_prev; return *this; }
+	Self operator--(int) { Self tmp = *this; m_node = m_node->m_prev; return tmp; }
+};
+
+// doubly linked, circular around a sentinel hook inside the list object.
+// Every operation on a single element is O(1), including unlink(x) of an
+// element found by other means, which is what an LRU list needs.
+template <class T, class HookAccess = base_hook<T, list_hook> >
+class intrusive_list
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef __intrusive_list_iterator<T, T&, T*, HookAccess> iterator;
+	typedef __intrusive_list_iterator<T, const T&, const T*, HookAccess> const_iterator;
+
+private:
+	list_hook m_root;
+
+	intrusive_list(const intrusive_list&);
+	intrusive_list& operator=(const intrusive_list&);
+
+	list_hook* __root() const { return const_cast<list_hook*>(&m_root); }
+
+	static void __unlink(list_hook* h)
+	{
+		h->m_prev->m_next = h->m_next;
+		h->m_next->m_prev = h->m_prev;
+		h->m_next = 0;
+		h->m_prev = 0;
+	}
+
+public:
+	intrusive_list() { m_root.m_next = m_root.m_prev = &m_root; }
+	// the elements are unlinked, not destroyed
+	~intrusive_list() { clear(); }
+
+	iterator begin() { return iterator(m_root.m_next); }
+	const_iterator begin() const { return const_iterator(m_root.m_next); }
+	iterator end() { return iterator(&m_root); }
+	const_iterator end() const { return const_iterator(__root()); }
+
+	bool empty() const { return m_root.m_next == &m_root; }
+	size_type size() const { return MySTL::distance(begin(), end()); }
+
+	reference front() { return *begin(); }
+	const_reference front() const { return *begin(); }
+	reference back() { return *HookAccess::to_value(m_root.m_prev); }
+	const_reference back() const { return *HookAccess::to_value(m_root.m_prev); }
+
+	// the iterator to an element that is in this list
+	static iterator iterator_to(T& x) { return iterator(HookAccess::to_hook(&x)); }
+	static const_iterator iterator_to(const T& x)
+	{
+		return const_iterator(HookAccess::to_hook(const_cast<T*>(&x)));
+	}
+
+	iterator insert(iterator pos, T& x)
+	{
+		list_hook* h = HookAccess::to_hook(&x);
+		h->m_next = pos.m_node;
+		h->m_prev = pos.m_node->m_prev;
+		pos.m_node->m_prev->m_next = h;
+		pos.m_node->m_prev = h;
+		return iterator(h);
+	}
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last)
+	{
+		for ( ; first != last; ++first)
+			insert(pos, *first);
+	}
+	void push_front(T& x) { insert(begin(), x); }
+	void push_back(T& x) { insert(end(), x); }
+
+	iterator erase(iterator pos)
+	{
+		iterator next(pos.m_node->m_next);
+		__unlink(pos.m_node);
+		return next;
+	}
+	iterator erase(iterator first, iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return last;
+	}
+	void pop_front() { __unlink(m_root.m_next); }
+	void pop_back() { __unlink(m_root.m_prev); }
+	// takes 'x' out of the list it is in, that list need not be at hand
+	static void unlink(T& x) { __unlink(HookAccess::to_hook(&x)); }
+	void clear() { erase(begin(), end()); }
+
+	void swap(intrusive_list& x)
+	{
+		list_hook tmp;
+		tmp.m_next = tmp.m_prev = &tmp;
+		if (!x.empty())
+			__list_transfer(&tmp, x.m_root.m_next, &x.m_root);
+		if (!empty())
+			__list_transfer(&x.m_root, m_root.m_next, &m_root);
+		if (tmp.m_next != &tmp)
+			__list_transfer(&m_root, tmp.m_next, &tmp);
+	}
+
+	void splice(iterator pos, intrusive_list& x)
+	{
+		if (!x.empty())
+			__list_transfer(pos.m_node, x.m_root.m_next, &x.m_root);
+	}
+	void splice(iterator pos, intrusive_list&, iterator i)
+	{
+		iterator j = i;
+		++j;
+		if (pos == i || pos == j)
+			return;
+		__list_transfer(pos.m_node, i.m_node, j.m_node);
+	}
+	void splice(iterator pos, intrusive_list&, iterator first, iterator last)
+	{
+		if (first != last)
+			__list_transfer(pos.m_node, first.m_node, last.m_node);
+	}
+
+	void reverse() { __list_reverse(&m_root); }
+
+	template <class Compare>
+	void merge(intrusive_list& x, Compare comp)
+	{
+		__list_merge(&m_root, &x.m_root, __hook_compare<HookAccess, T, Compare>(comp));
+	}
+	void merge(intrusive_list& x) { merge(x, less<T>()); }
+
+	template <class Compare>
+	void sort(Compare comp) { __list_sort(&m_root, __hook_compare<HookAccess, T, Compare>(comp)); }
+	void sort() { sort(less<T>()); }
+};
+
+template <class T, class Ref, class Ptr, class HookAccess>
+struct __intrusive_slist_iterator
+{
+	typedef forward_iterator_tag category;
+	typedef T value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef ptrdiff_t difference_type;
+	typedef __intrusive_slist_iterator<T, Ref, Ptr, HookAccess> Self;
+	typedef __intrusive_slist_iterator<T, T&, T*, HookAccess> iterator;
+
+	slist_hook* m_node;
+
+	__intrusive_slist_iterator(slist_hook* node = 0) : m_node(node) {}
+	__intrusive_slist_iterator(const iterator& x) : m_node(x.m_node) {}
+
+	reference operator*() const { return *HookAccess::to_value(m_node); }
+	pointer operator->() const { return HookAccess::to_value(m_node); }
+	bool operator==(const Self& x) const { return m_node == x.m_node; }
+	bool operator!=(const Self& x) const { return m_node != x.m_node; }
+	Self& operator++() { m_node = m_node->m_next; return *this; }
+	Self operator++(int) { Self tmp = *this; m_node = m_node->m_next; return tmp; }
+};
+
+// singly linked and null terminated, the head hook is inside the list
+// object. The front is O(1), anything before a given element is a walk.
+// Suits free lists and stacks of objects.
+template <class T, class HookAccess = base_hook<T, slist_hook> >
+class intrusive_slist
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef __intrusive_slist_iterator<T, T&, T*, HookAccess> iterator;
+	typedef __intrusive_slist_iterator<T, const T&, const T*, HookAccess> const_iterator;
+
+private:
+	slist_hook m_head;
+
+	intrusive_slist(const intrusive_slist&);
+	intrusive_slist& operator=(const intrusive_slist&);
+
+	slist_hook* __head() const { return const_cast<slist_hook*>(&m_head); }
+
+public:
+	intrusive_slist() {}
+	~intrusive_slist() { clear(); }
+
+	iterator begin() { return iterator(m_head.m_next); }
+	const_iterator begin() const { return const_iterator(m_head.m_next); }
+	iterator end() { return iterator(); }
+	const_iterator end() const { return const_iterator(); }
+	iterator before_begin() { return iterator(&m_head); }
+	const_iterator before_begin() const { return const_iterator(__head()); }
+
+	bool empty() const { return m_head.m_next == 0; }
+	size_type size() const { return __slist_size(m_head.m_next); }
+
+	reference front() { return *HookAccess::to_value(m_head.m_next); }
+	const_reference front() const { return *HookAccess::to_value(m_head.m_next); }
+
+	static iterator iterator_to(T& x) { return iterator(HookAccess::to_hook(&x)); }
+	iterator previous(const_iterator pos) { return iterator(__slist_previous(&m_head, pos.m_node)); }
+
+	void push_front(T& x) { __slist_make_link(&m_head, HookAccess::to_hook(&x)); }
+	void pop_front()
+	{
+		slist_hook* h = m_head.m_next;
+		m_head.m_next = h->m_next;
+		h->m_next = 0;
+	}
+	iterator insert_after(iterator pos, T& x)
+	{
+		return iterator(__slist_make_link(pos.m_node, HookAccess::to_hook(&x)));
+	}
+	// unlinks the element after 'pos' and returns the one after that
+	iterator erase_after(iterator pos)
+	{
+		slist_hook* h = pos.m_node->m_next;
+		pos.m_node->m_next = h->m_next;
+		h->m_next = 0;
+		return iterator(pos.m_node->m_next);
+	}
+	void clear()
+	{
+		while (m_head.m_next)
+			pop_front();
+	}
+
+	void swap(intrusive_slist& x) { MySTL::swap(m_head.m_next, x.m_head.m_next); }
+
+	// moves (before_first, before_last] after 'pos'
+	void splice_after(iterator pos, iterator before_first, iterator before_last)
+	{
+		if (before_first != before_last)
+			__slist_splice_after(pos.m_node, before_first.m_node, before_last.m_node);
+	}
+	void splice_after(iterator pos, intrusive_slist& x)
+	{
+		__slist_splice_after(pos.m_node, &x.m_head);
+	}
+
+	void reverse() { m_head.m_next = __slist_reverse(m_head.m_next); }
+
+	template <class Compare>
+	void merge(intrusive_slist& x, Compare comp)
+	{
+		m_head.m_next = __slist_merge_chains(m_head.m_next, x.m_head.m_next,
+			__hook_compare<HookAccess, T, Compare>(comp));
+		x.m_head.m_next = 0;
+	}
+	void merge(intrusive_slist& x) { merge(x, less<T>()); }
+
+	template <class Compare>
+	void sort(Compare comp)
+	{
+		m_head.m_next = __slist_sort_chain(m_head.m_next, __hook_compare<HookAccess, T, Compare>(comp));
+	}
+	void sort() { sort(less<T>()); }
+};
+
+__NS_END
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include "type_traits.h"
 
 __NS_BEGIN
 
@@ -157,4 +158,17 @@ inline void distance(InputIterator first, InputIterator last, Distance& n)
 	__distance(first, last, n, iterator_category(first));
 }
 
+// Iterators over a sequence of contiguous segments, such as deque blocks,
+// specialize this with is_segmented = true_type and
+//   segment_iterator, local_iterator   the segments, and a pointer into one
+//   segment(i), local(i)               where 'i' is
+//   begin(s), end(s)                   the bounds of segment 's'
+//   compose(s, l)                      the iterator for 'l' in 's'
+// Algorithms then split a range into segments and run on local iterators.
+template <class Iterator>
+struct segmented_iterator_traits
+{
+	typedef false_type is_segmented;
+};
+
 __NS_END
\ No newline at end of file
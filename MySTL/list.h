@@ -2,7 +2,9 @@
 
 #include "algo_base.h"
 #include "allocator.h"
+#include "pool_allocator.h"
 #include "initialize.h"
+#include "slist.h"
 
 __NS_BEGIN
 
@@ -14,6 +16,83 @@ struct __list_node
 	__list_node* m_prev;
 };
 
+// Node level algorithms for circular lists with a sentinel 'head', for any
+// node type with 'm_next' and 'm_prev'; the intrusive lists use them too.
+
+// moves [first, last) in front of 'pos'
+template <class Node>
+void __list_transfer(Node* pos, Node* first, Node* last)
+{
+	if (pos != last)
+	{
+		first->m_prev->m_next = last;
+		Node* last_prev = last->m_prev;
+		last->m_prev = first->m_prev;
+		pos->m_prev->m_next = first;
+		first->m_prev = pos->m_prev;
+		last_prev->m_next = pos;
+		pos->m_prev = last_prev;
+	}
+}
+
+template <class Node>
+void __list_reverse(Node* head)
+{
+	Node* p = head;
+	do
+	{
+		MySTL::swap(p->m_prev, p->m_next);
+		p = p->m_prev;
+	}
+	while (p != head);
+}
+
+// moves the nodes of sorted 'head2' into sorted 'head1', stable
+template <class Node, class Compare>
+void __list_merge(Node* head1, Node* head2, Compare comp)
+{
+	Node* first1 = head1->m_next;
+	Node* first2 = head2->m_next;
+	while (first1 != head1 && first2 != head2)
+	{
+		if (comp(first2, first1))
+		{
+			Node* next = first2->m_next;
+			__list_transfer(first1, first2, next);
+			first2 = next;
+		}
+		else
+			first1 = first1->m_next;
+	}
+	if (first2 != head2)
+		__list_transfer(head1, first2, head2);
+}
+
+// sorts the forward links as a null terminated chain, then restores the
+// backward links in one pass
+template <class Node, class Compare, class Engine>
+void __list_sort(Node* head, Compare comp, Engine engine)
+{
+	if (head->m_next == head || head->m_next->m_next == head)
+		return;
+	head->m_prev->m_next = 0;
+	head->m_next = __slist_sort_chain(head->m_next, comp, engine);
+	Node* prev = head;
+	for (Node* p = head->m_next; p; p = p->m_next)
+	{
+		p->m_prev = prev;
+		prev = p;
+	}
+	prev->m_next = head;
+	head->m_prev = prev;
+}
+
+template <class Node, class Compare>
+void __list_sort(Node* head, Compare comp)
+{
+	__list_sort(head, comp, __serial_sort_engine());
+}
+
 template <class Tp, class Ref, class Ptr>
 struct __list_iterator
 {
@@ -58,7 +137,7 @@ struct __list_iterator
 	}
 };
 
-template <class Tp, class Alloc = type_allocator<__list_node<Tp> > >
+template <class Tp, class Alloc = type_allocator<__list_node<Tp>, pool_allocator> >
 class list
 {
 public:
@@ -70,27 +149,52 @@ public:
 	typedef size_t size_type;
 	typedef ptrdiff_t difference_type;
 	typedef __list_node<Tp> Node;
+	typedef Alloc allocator_type;
 
 	typedef __list_iterator<Tp,Tp&,Tp*>             iterator;
 	typedef __list_iterator<Tp,const Tp&,const Tp*> const_iterator;
 
 protected:
 	Node* m_node;
-	Node* __get_node() { return Alloc::allocate(1); }
-	void __put_node(Node* p) { return Alloc::deallocate(p, 1); }
+	// the element count together with the allocator
+	__alloc_pair<Alloc, size_type> m_size;
+
+	size_type& __size() { return m_size.m_value; }
+	size_type __size() const { return m_size.m_value; }
+	Alloc& __alloc() { return m_size.__alloc(); }
+	const Alloc& __alloc() const { return m_size.__alloc(); }
+	Node* __get_node() { return __alloc().allocate(1); }
+	void __put_node(Node* p) { return __alloc().deallocate(p, 1); }
 	Node* __create_node(const Tp& x)
 	{
 		Node* p = __get_node();
-		construct(&p->m_data, x);
+		try
+		{
+			construct(&p->m_data, x);
+		}
+		catch (...)
+		{
+			__put_node(p);
+			throw;
+		}
 		return p;
 	}
 	Node* __create_node() { return __create_node(Tp()); }
+
+	static void __link_before(Node* pos, Node* p)
+	{
+		p->m_next = pos;
+		p->m_prev = pos->m_prev;
+		pos->m_prev->m_next = p;
+		pos->m_prev = p;
+	}
 	
 	void __initialize_empty()
 	{
 		m_node = __get_node();
 		m_node->m_next = m_node;
 		m_node->m_prev = m_node;
+		__size() = 0;
 	}
 	void __fill_initialize(size_type n, const Tp& x);
 	template <class Integer>
@@ -98,10 +202,42 @@ protected:
 	template <class InputIterator>
 	void __initialize_aux(InputIterator first, InputIterator last, false_type);
 
-	void __fill_insert(iterator pos, size_type n, const Tp& x)
+	// bulk insertions take all their nodes from one allocate_chain() call,
+	// which the default pool_allocator carves from one chunk; every node
+	// counts once it is linked, and if a copy throws the nodes not linked
+	// yet go back to the allocator
+	void __put_chain(Node* chain, size_type n)
 	{
 		for ( ; n > 0; --n)
-			insert(pos, x);
+		{
+			Node* p = chain;
+			chain = (Node*)__chain_next(p);
+			__put_node(p);
+		}
+	}
+	void __fill_insert(iterator pos, size_type n, const Tp& x)
+	{
+		Node* chain = __alloc().allocate_chain(n);
+		Node* next = 0;
+		size_type i = 0;
+		try
+		{
+			for ( ; i < n; ++i)
+			{
+				next = (Node*)__chain_next(chain);
+				construct(&chain->m_data, x);
+				__link_before(pos.m_node, chain);
+				++__size();
+				chain = next;
+			}
+		}
+		catch (...)
+		{
+			// the failed copy may have overwritten the link of its node
+			__put_node(chain);
+			__put_chain(next, n - i - 1);
+			throw;
+		}
 	}
 	template <class Integer>
 	void __insert_aux(iterator pos, Integer n, Integer x, true_type)
@@ -110,10 +246,39 @@ protected:
 	}
 	template <class InputIterator>
 	void __insert_aux(iterator pos, InputIterator first, InputIterator last, false_type)
+	{
+		__range_insert(pos, first, last, iterator_category(first));
+	}
+	template <class InputIterator>
+	void __range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
 	{
 		for ( ; first != last; ++first)
 			insert(pos, *first);
 	}
+	template <class ForwardIterator>
+	void __range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = MySTL::distance(first, last);
+		Node* chain = __alloc().allocate_chain(n);
+		Node* next = 0;
+		try
+		{
+			for ( ; first != last; ++first, --n)
+			{
+				next = (Node*)__chain_next(chain);
+				construct(&chain->m_data, *first);
+				__link_before(pos.m_node, chain);
+				++__size();
+				chain = next;
+			}
+		}
+		catch (...)
+		{
+			__put_node(chain);
+			__put_chain(next, n - 1);
+			throw;
+		}
+	}
 
 	void __fill_assign(size_type n, const Tp& x)
 	{
@@ -149,23 +314,27 @@ protected:
 
 public:
 	list() { __initialize_empty(); }
-	list(size_type n, const Tp& x)
+	explicit list(const Alloc& a) : m_size(a, 0) { __initialize_empty(); }
+	list(size_type n, const Tp& x, const Alloc& a = Alloc())
+		: m_size(a, 0)
 	{
 		__initialize_empty();
-		__fill_insert(n, x);
+		__fill_insert(end(), n, x);
 	}
 	explicit list(size_type n)
 	{
 		__initialize_empty();
-		__fill_insert(n, Tp());
+		__fill_insert(end(), n, Tp());
 	}
 	template <class InputIterator>
-	list(InputIterator first, InputIterator last)
+	list(InputIterator first, InputIterator last, const Alloc& a = Alloc())
+		: m_size(a, 0)
 	{
 		__initialize_empty();
 		insert(end(), first, last);
 	}
 	list(const list<Tp, Alloc>& other)
+		: m_size(other.__alloc(), 0)
 	{
 		__initialize_empty();
 		insert(end(), other.begin(), other.end());
@@ -178,24 +347,24 @@ public:
 	iterator end() { return iterator(m_node); }
 	const_iterator end() const { return const_iterator(m_node); }
 	bool empty() const { return m_node == m_node->m_next; }
-	size_type size() const { return distance(begin(), end()); }
+	size_type size() const { return __size(); }
 	reference front() { return *begin(); }
 	const_reference front() const { return *begin(); }
 	reference back() { return *--end(); }
 	const_reference back() const { return *--end(); }
+	allocator_type get_allocator() const { return __alloc(); }
 
 	void swap(list<Tp, Alloc>& x)
 	{
-		::swap(m_node, x.m_node);
+		MySTL::swap(m_node, x.m_node);
+		MySTL::swap(m_size, x.m_size);
 	}
 
 	iterator insert(iterator pos, const Tp& x)
 	{
 		Node* p = __create_node(x);
-		p->m_next = pos.m_node;
-		p->m_prev = pos.m_node->m_prev;
-		pos.m_node->m_prev->m_next = p;
-		pos.m_node->m_prev = p;
+		__link_before(pos.m_node, p);
+		++__size();
 		return p;
 	}
 	void insert(iterator pos, size_type n, const Tp& x)
@@ -220,6 +389,7 @@ public:
 			p->m_next->m_prev = p->m_prev;
 			destruct(&p->m_data);
 			__put_node(p);
+			--__size();
 		}
 		return pos;
 	}
@@ -244,6 +414,7 @@ public:
 		Node* p = m_node->m_next;
 		m_node->m_next = m_node;
 		m_node->m_prev = m_node;
+		__size() = 0;
 		Node* d = 0;
 		while (p != m_node)
 		{
@@ -256,12 +427,10 @@ public:
 
 	void resize(size_type new_size, const Tp& x)
 	{
-		size_type old_sz = distance(begin(), end());
-		if (old_sz < new_size)
-			for (size_type n = new_size - old_sz; n > 0; --n)
-				push_back(x);
+		if (__size() < new_size)
+			__fill_insert(end(), new_size - __size(), x);
 		else
-			for (size_type n = old_sz - new_size; n > 0; --n)
+			for (size_type n = __size() - new_size; n > 0; --n)
 				pop_back();
 	}
 	void resize(size_type new_size) { resize(new_size, Tp()); }
@@ -277,39 +446,47 @@ public:
 		__assign_aux(first, last, is_int());
 	}
 
+	// moves [first, last) of this list in front of 'pos', the splices
+	// move nodes between lists and keep both sizes
 	void transfer(iterator pos, iterator first, iterator last)
 	{
-		if (pos != last)
-		{
-			first.m_node->m_prev->m_next = last.m_node;
-			Node* last_prev = last.m_node->m_prev;
-			last.m_node->m_prev = first.m_node->m_prev;
-			pos.m_node->m_prev->m_next = first.m_node;
-			first.m_node->m_prev = pos.m_node->m_prev;
-			last_prev->m_next = pos.m_node;
-			pos.m_node->m_prev = last_prev;
-		}
+		__list_transfer(pos.m_node, first.m_node, last.m_node);
 	}
 
 	void splice(iterator pos, list& x)
 	{
 		if (!x.empty())
+		{
 			transfer(pos, x.begin(), x.end());
+			__size() += x.__size();
+			x.__size() = 0;
+		}
 	}
 
-	void splice(iterator pos, list&, iterator i)
+	void splice(iterator pos, list& x, iterator i)
 	{
 		iterator j = i;
 		++j;
 		if (pos == i || pos == j) 
 			return;
 		transfer(pos, i, j);
+		++__size();
+		--x.__size();
 	}
 
-	void splice(iterator pos, list&, iterator first, iterator last)
+	// O(n) in the length of the range when 'x' is another list
+	void splice(iterator pos, list& x, iterator first, iterator last)
 	{
 		if (first != last)
+		{
+			if (&x != this)
+			{
+				size_type n = MySTL::distance(first, last);
+				__size() += n;
+				x.__size() -= n;
+			}
 			this->transfer(pos, first, last);
+		}
 	}
 
 	void remove(const Tp& x)
@@ -337,67 +514,33 @@ public:
 		}
 	}
 
-	void reverse()
-	{
-		Node* p = m_node;
-		do
-		{
-			::swap(p->m_prev, p->m_next);
-			p = p->m_prev;
-		}
-		while(p != m_node);
-	}
+	void reverse() { __list_reverse(m_node); }
 
 	void merge(list& x)
 	{
-		iterator first1 = begin();
-		iterator end1 = end();
-		iterator first2 = x.begin();
-		iterator end2 = x.end();
-		while (first1 != end1 && first2 != end2)
-		{
-			if (*first2 < *first1)
-			{
-				iterator next = first2;
-				++next;
-				transfer(first1, first2, next);
-				first2 = next;
-			}
-			else
-				++first1;
-		}
-		if (first2 != end2)
-			transfer(end1, first2, end2);
-	}
-
-	void sort()
-	{
-		if (m_node->m_next == m_node || m_node->m_next->m_next == m_node)
+		if (&x == this)
 			return;
-		const size_t MAX_BINS = 64;
-		list<Tp, Alloc> tmp_list;
-		list<Tp, Alloc> bin_list[MAX_BINS + 1];
-		size_t current_max_bin = 0;
-
-		while (!empty())
-		{	
-			tmp_list.splice(tmp_list.begin(), *this, begin(), ++begin());
-			size_t bin = 0;
-			for ( ; bin < current_max_bin && !bin_list[bin].empty(); ++bin)
-			{
-				// to keep stable, do not use tmp_list.merge(bin_list[bin]);
-				bin_list[bin].merge(tmp_list);
-				bin_list[bin].swap(tmp_list);
-			}
-			tmp_list.swap(bin_list[bin]);
-			if (bin == current_max_bin)
-				++current_max_bin;
-		}
+		__list_merge(m_node, x.m_node, __node_data_less<Node>());
+		__size() += x.__size();
+		x.__size() = 0;
+	}
+
+	// no helper lists and no element is copied; a long list is sorted
+	// through an array of its node pointers (integers by radix), without
+	// memory for that array by its links
+	void sort() { __list_sort(m_node, __node_data_less<Node>()); }
+#if defined(__MYSTL_CXX11)
+	// the same order as sort(), a long list is sorted on the workers of
+	// 'pool' (thread_pool.h)
+	void sort(thread_pool& pool) { __list_sort(m_node, __node_data_less<Node>(), __parallel_sort_engine(pool)); }
+#endif
+};
 
-		for (size_t bin = 1; bin < current_max_bin; ++bin)
-			bin_list[bin].merge(bin_list[bin - 1]);
-		splice(begin(), bin_list[current_max_bin - 1]);
-	}
+// the sentinel node lives on the heap
+template <class Tp, class Alloc>
+struct is_trivially_relocatable<list<Tp, Alloc> >
+{
+	typedef true_type type;
 };
 
 __NS_END
\ No newline at end of file
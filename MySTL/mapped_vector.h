@@ -0,0 +1,480 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include "algo_base.h"
+#include "initialize.h"
+#include "type_traits.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+__NS_BEGIN
+
+// address space reserved by default, in bytes
+enum { __MAPPED_DEFAULT_RESERVE = 64 * 1024 * 1024 };
+
+// Vector for very large arrays. Instead of a heap block it reserves a range
+// of address space up front and commits pages as it grows, so growth never
+// copies and never needs old and new storage at the same time. Once the
+// reservation is used up it is enlarged with mremap, which moves page
+// table entries, not data (Linux; Windows and other systems copy once per
+// new reservation).
+//
+// With a file name the elements live in that file (MAP_SHARED) and the
+// file is truncated to size() elements when the vector is destroyed, so a
+// later mapped_vector on the same file sees the same elements again. Not
+// available on Windows.
+//
+// Elements are moved bitwise, T must be trivially relocatable, and POD for
+// a file to be meaningful across runs. Mapping failures throw bad_alloc.
+template <class T>
+class mapped_vector
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+private:
+	T* m_start;
+	T* m_finish;
+	T* m_end_of_storage;
+	size_t m_committed;	// bytes usable from m_start
+	size_t m_reserved;	// bytes of address space from m_start
+	int m_fd;			// -1 for anonymous memory
+
+	static size_t __page_size()
+	{
+#if defined(_WIN32)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwAllocationGranularity;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	static size_t __round_to_pages(size_t bytes)
+	{
+		size_t page = __page_size();
+		return (bytes + page - 1) / page * page;
+	}
+
+	void __init(int fd)
+	{
+		m_start = m_finish = m_end_of_storage = 0;
+		m_committed = m_reserved = 0;
+		m_fd = fd;
+	}
+
+	void __set_committed(size_t bytes)
+	{
+		m_committed = bytes;
+		m_end_of_storage = m_start + bytes / sizeof(T);
+	}
+
+	// reserves 'bytes' of address space without committing anything
+	void __map(size_t bytes)
+	{
+		void* p;
+#if defined(_WIN32)
+		p = VirtualAlloc(0, bytes, MEM_RESERVE, PAGE_NOACCESS);
+		if (p == 0)
+			throw std::bad_alloc();
+#else
+		if (m_fd >= 0)
+			p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		else
+			p = mmap(0, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (p == MAP_FAILED)
+			throw std::bad_alloc();
+#endif
+		m_start = m_finish = (T*)p;
+		m_reserved = bytes;
+		__set_committed(0);
+	}
+
+	void __unmap()
+	{
+		if (m_start == 0)
+			return;
+#if defined(_WIN32)
+		VirtualFree(m_start, 0, MEM_RELEASE);
+#else
+		munmap(m_start, m_reserved);
+#endif
+	}
+
+	// enlarges the reservation to 'bytes', the elements may move
+	void __remap(size_t bytes)
+	{
+		size_type n = size();
+		void* p;
+#if defined(__linux__)
+		if (m_fd >= 0)
+			p = mremap(m_start, m_reserved, bytes, MREMAP_MAYMOVE);
+		else
+		{
+			// mremap refuses a range of mixed protections, so only the
+			// committed pages are moved, into a new PROT_NONE reservation
+			p = mmap(0, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (p != MAP_FAILED && m_committed != 0 &&
+				mremap(m_start, m_committed, m_committed, MREMAP_MAYMOVE | MREMAP_FIXED, p) == MAP_FAILED)
+			{
+				munmap(p, bytes);
+				p = MAP_FAILED;
+			}
+			if (p != MAP_FAILED && m_reserved != m_committed)
+				munmap((char*)m_start + m_committed, m_reserved - m_committed);
+		}
+		if (p == MAP_FAILED)
+			throw std::bad_alloc();
+#else
+		// no mremap: map a larger range, anonymous memory is copied over
+		T* old_start = m_start;
+		size_t old_reserved = m_reserved;
+		size_t committed = m_committed;
+		__map(bytes);
+		p = m_start;
+#if defined(_WIN32)
+		if (VirtualAlloc(p, committed, MEM_COMMIT, PAGE_READWRITE) == 0)
+			throw std::bad_alloc();
+		memcpy(p, (void*)old_start, n * sizeof(T));
+		VirtualFree(old_start, 0, MEM_RELEASE);
+#else
+		if (m_fd < 0)
+		{
+			if (mprotect(p, committed, PROT_READ | PROT_WRITE) != 0)
+				throw std::bad_alloc();
+			memcpy(p, (void*)old_start, n * sizeof(T));
+		}
+		munmap(old_start, old_reserved);
+#endif
+		m_committed = committed;
+#endif
+		m_start = (T*)p;
+		m_finish = m_start + n;
+		m_reserved = bytes;
+		__set_committed(m_committed);
+	}
+
+	// makes the first 'bytes' (page multiple) of the reservation usable
+	void __commit(size_t bytes)
+	{
+		if (bytes <= m_committed)
+			return;
+		if (m_start == 0)
+			__map(MySTL::max(bytes, __round_to_pages(__MAPPED_DEFAULT_RESERVE)));
+		else if (bytes > m_reserved)
+			__remap(MySTL::max(bytes, 2 * m_reserved));
+#if defined(_WIN32)
+		if (VirtualAlloc((char*)m_start + m_committed, bytes - m_committed, MEM_COMMIT, PAGE_READWRITE) == 0)
+			throw std::bad_alloc();
+#else
+		if (m_fd >= 0)
+		{
+			if (ftruncate(m_fd, bytes) != 0)
+				throw std::bad_alloc();
+		}
+		else if (mprotect((char*)m_start + m_committed, bytes - m_committed, PROT_READ | PROT_WRITE) != 0)
+			throw std::bad_alloc();
+#endif
+		__set_committed(bytes);
+	}
+
+	void __grow_for(size_type n)
+	{
+		if (size_type(m_end_of_storage - m_finish) < n)
+			reserve(size() + MySTL::max(size(), n));
+	}
+
+	void __fill_insert(iterator pos, size_type n, const T& x)
+	{
+		if (n == 0)
+			return;
+		T x_copy = x;
+		size_type index = pos - m_start;
+		__grow_for(n);
+		pos = m_start + index;
+		__relocation_gap<T> gap(pos, n, m_finish);
+		fill_construct_n(pos, n, x_copy);
+		gap.__fill();
+	}
+
+	template <class InputIterator>
+	void __range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		size_type index = pos - m_start;
+		for ( ; first != last; ++first, ++index)
+			insert(m_start + index, *first);
+	}
+	template <class ForwardIterator>
+	void __range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = MySTL::distance(first, last);
+		if (n == 0)
+			return;
+		size_type index = pos - m_start;
+		__grow_for(n);
+		pos = m_start + index;
+		__relocation_gap<T> gap(pos, n, m_finish);
+		range_construct(first, last, pos);
+		gap.__fill();
+	}
+	template <class Integer>
+	void __insert_aux(iterator pos, Integer n, Integer x, true_type)
+	{
+		__fill_insert(pos, n, x);
+	}
+	template <class InputIterator>
+	void __insert_aux(iterator pos, InputIterator first, InputIterator last, false_type)
+	{
+		__range_insert(pos, first, last, iterator_category(first));
+	}
+
+public:
+	mapped_vector() { __init(-1); }
+
+	explicit mapped_vector(size_type n)
+	{
+		__init(-1);
+		__fill_insert(end(), n, T());
+	}
+
+#if !defined(_WIN32)
+	// opens or creates 'path', its current contents become the elements;
+	// 'reserve_n' elements of address space are reserved, 0 for the default
+	mapped_vector(const char* path, size_type reserve_n)
+	{
+		__init(open(path, O_RDWR | O_CREAT, 0644));
+		struct stat st;
+		if (m_fd < 0 || fstat(m_fd, &st) != 0)
+		{
+			if (m_fd >= 0)
+				close(m_fd);
+			throw std::bad_alloc();
+		}
+		size_t file_bytes = (size_t)st.st_size;
+		size_t reserve_bytes = MySTL::max(__round_to_pages(reserve_n * sizeof(T)), __round_to_pages(file_bytes));
+		reserve_bytes = MySTL::max(reserve_bytes, __round_to_pages(__MAPPED_DEFAULT_RESERVE));
+		__map(reserve_bytes);
+		__set_committed(file_bytes);
+		m_finish = m_start + file_bytes / sizeof(T);
+	}
+#endif
+
+	mapped_vector(size_type n, const T& x)
+	{
+		__init(-1);
+		__fill_insert(end(), n, x);
+	}
+	template <class InputIterator>
+	mapped_vector(InputIterator first, InputIterator last)
+	{
+		__init(-1);
+		insert(end(), first, last);
+	}
+	// the copy is always anonymous memory
+	mapped_vector(const mapped_vector<T>& other)
+	{
+		__init(-1);
+		insert(end(), other.begin(), other.end());
+	}
+#if defined(__MYSTL_CXX11)
+	mapped_vector(mapped_vector<T>&& other)
+	{
+		__init(-1);
+		swap(other);
+	}
+#endif
+
+	~mapped_vector()
+	{
+		range_destruct(m_start, m_finish);
+#if !defined(_WIN32)
+		if (m_fd >= 0)
+		{
+			// the file length records the number of elements
+			int truncated = ftruncate(m_fd, size() * sizeof(T));
+			(void)truncated;
+			close(m_fd);
+		}
+#endif
+		__unmap();
+	}
+
+	iterator begin() { return m_start; }
+	const_iterator begin() const { return m_start; }
+	iterator end() { return m_finish; }
+	const_iterator end() const { return m_finish; }
+	size_type size() const { return m_finish - m_start; }
+	size_type capacity() const { return m_end_of_storage - m_start; }
+	// elements that fit into the reserved address space without a remap
+	size_type reserved() const { return m_reserved / sizeof(T); }
+	bool empty() const { return m_start == m_finish; }
+	bool is_file_backed() const { return m_fd >= 0; }
+	reference front() { return *m_start; }
+	const_reference front() const { return *m_start; }
+	reference back() { return *(m_finish - 1); }
+	const_reference back() const { return *(m_finish - 1); }
+
+	T& operator[](size_type index) { return m_start[index]; }
+	const T& operator[](size_type index) const { return m_start[index]; }
+
+	void reserve(size_type n)
+	{
+		if (n > capacity())
+			__commit(__round_to_pages(n * sizeof(T)));
+	}
+
+	// reserves address space for 'n' elements up front, nothing is committed
+	void reserve_address_space(size_type n)
+	{
+		size_t bytes = __round_to_pages(n * sizeof(T));
+		if (bytes <= m_reserved)
+			return;
+		if (m_start == 0)
+			__map(bytes);
+		else
+			__remap(bytes);
+	}
+
+	void push_back(const T& x)
+	{
+		if (m_finish != m_end_of_storage)
+		{
+			construct(m_finish, x);
+			++m_finish;
+		}
+		else
+			insert(end(), x);
+	}
+	void insert(iterator pos, const T& x)
+	{
+		T x_copy = x;
+		size_type index = pos - m_start;
+		__grow_for(1);
+		pos = m_start + index;
+		__relocation_gap<T> gap(pos, 1, m_finish);
+		construct(pos, x_copy);
+		gap.__fill();
+	}
+	void insert(iterator pos, size_type n, const T& x) { __fill_insert(pos, n, x); }
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last)
+	{
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__insert_aux(pos, first, last, is_int());
+	}
+
+	iterator erase(iterator pos) { return erase(pos, pos + 1); }
+	iterator erase(iterator first, iterator last)
+	{
+		range_destruct(first, last);
+		memmove((void*)first, (void*)last, (m_finish - last) * sizeof(T));
+		m_finish -= last - first;
+		return first;
+	}
+	void pop_back()
+	{
+		--m_finish;
+		destruct(m_finish);
+	}
+	void clear() { erase(m_start, m_finish); }
+
+	void resize(size_type new_sz, const T& x)
+	{
+		if (new_sz > size())
+			__fill_insert(m_finish, new_sz - size(), x);
+		else
+			erase(m_start + new_sz, m_finish);
+	}
+	void resize(size_type new_sz) { resize(new_sz, T()); }
+
+	// gives the pages past size() back to the system, the reservation stays
+	void shrink_to_fit()
+	{
+		size_t bytes = __round_to_pages(size() * sizeof(T));
+		if (bytes >= m_committed)
+			return;
+#if defined(_WIN32)
+		VirtualFree((char*)m_start + bytes, m_committed - bytes, MEM_DECOMMIT);
+#else
+		if (m_fd >= 0)
+		{
+			if (ftruncate(m_fd, bytes) != 0)
+				return;
+		}
+		else
+		{
+			madvise((char*)m_start + bytes, m_committed - bytes, MADV_DONTNEED);
+			mprotect((char*)m_start + bytes, m_committed - bytes, PROT_NONE);
+		}
+#endif
+		__set_committed(bytes);
+	}
+
+	// writes the elements back to the file
+	void sync()
+	{
+#if !defined(_WIN32)
+		if (m_fd >= 0 && m_committed != 0)
+			msync(m_start, m_committed, MS_SYNC);
+#endif
+	}
+
+	void assign(size_type n, const T& x)
+	{
+		clear();
+		__fill_insert(m_finish, n, x);
+	}
+	template <class InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		insert(m_finish, first, last);
+	}
+	mapped_vector<T>& operator=(const mapped_vector<T>& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	mapped_vector<T>& operator=(mapped_vector<T>&& other)
+	{
+		swap(other);
+		return *this;
+	}
+#endif
+
+	void swap(mapped_vector<T>& other)
+	{
+		MySTL::swap(m_start, other.m_start);
+		MySTL::swap(m_finish, other.m_finish);
+		MySTL::swap(m_end_of_storage, other.m_end_of_storage);
+		MySTL::swap(m_committed, other.m_committed);
+		MySTL::swap(m_reserved, other.m_reserved);
+		MySTL::swap(m_fd, other.m_fd);
+	}
+};
+
+__NS_END
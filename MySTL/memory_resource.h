@@ -0,0 +1,473 @@
+#pragma once
+
+#include <new>
+#include "config.h"
+#include "allocator.h"
+
+__NS_BEGIN
+
+enum { __DEFAULT_RESOURCE_ALIGN = __MALLOC_ALIGN };
+
+inline size_t __align_up(size_t n, size_t align)
+{
+	return (n + align - 1) & ~(align - 1);
+}
+
+inline char* __align_up(char* p, size_t align)
+{
+	return (char*)(((size_t)p + align - 1) & ~(align - 1));
+}
+
+// Abstract source of raw memory. Containers reach it through a
+// polymorphic_allocator, so one container instance can be pointed at an
+// arena while another of the same type keeps using the heap.
+class memory_resource
+{
+public:
+	virtual ~memory_resource() {}
+
+	void* allocate(size_t bytes, size_t align = __DEFAULT_RESOURCE_ALIGN)
+	{
+		return do_allocate(bytes, align);
+	}
+	void deallocate(void* p, size_t bytes, size_t align = __DEFAULT_RESOURCE_ALIGN)
+	{
+		do_deallocate(p, bytes, align);
+	}
+	bool is_equal(const memory_resource& other) const
+	{
+		return do_is_equal(other);
+	}
+
+protected:
+	virtual void* do_allocate(size_t bytes, size_t align) = 0;
+	virtual void do_deallocate(void* p, size_t bytes, size_t align) = 0;
+	virtual bool do_is_equal(const memory_resource& other) const { return this == &other; }
+};
+
+inline bool operator==(const memory_resource& a, const memory_resource& b)
+{
+	return &a == &b || a.is_equal(b);
+}
+
+inline bool operator!=(const memory_resource& a, const memory_resource& b)
+{
+	return !(a == b);
+}
+
+class __new_delete_resource : public memory_resource
+{
+protected:
+	void* do_allocate(size_t bytes, size_t align) { return allocator::allocate(bytes, align); }
+	void do_deallocate(void* p, size_t bytes, size_t align) { allocator::deallocate(p, bytes, align); }
+};
+
+class __null_memory_resource : public memory_resource
+{
+protected:
+	void* do_allocate(size_t, size_t) { throw std::bad_alloc(); }
+	void do_deallocate(void*, size_t, size_t) {}
+};
+
+// forwards to 'allocator'
+inline memory_resource* new_delete_resource()
+{
+	static __new_delete_resource resource;
+	return &resource;
+}
+
+// every allocation fails, useful as the upstream of a fixed buffer
+inline memory_resource* null_memory_resource()
+{
+	static __null_memory_resource resource;
+	return &resource;
+}
+
+inline memory_resource*& __default_resource()
+{
+	static memory_resource* resource = new_delete_resource();
+	return resource;
+}
+
+inline memory_resource* get_default_resource()
+{
+	return __default_resource();
+}
+
+// returns the previous default resource, 0 restores new_delete_resource()
+inline memory_resource* set_default_resource(memory_resource* r)
+{
+	memory_resource* old = __default_resource();
+	__default_resource() = r ? r : new_delete_resource();
+	return old;
+}
+
+// Bump allocator. Blocks are carved from an optional initial buffer and
+// then from chunks of geometrically growing size taken from the upstream
+// resource. deallocate() is a no-op; all memory is given back at once by
+// release() or by the destructor.
+class monotonic_buffer_resource : public memory_resource
+{
+public:
+	explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource())
+		: m_upstream(upstream), m_chunks(0), m_current(0), m_end(0),
+		  m_next_chunk_size(__INITIAL_CHUNK_SIZE), m_initial_buffer(0), m_initial_size(0)
+	{}
+	explicit monotonic_buffer_resource(size_t initial_size, memory_resource* upstream = get_default_resource())
+		: m_upstream(upstream), m_chunks(0), m_current(0), m_end(0),
+		  m_next_chunk_size(initial_size < 64 ? 64 : initial_size),
+		  m_initial_buffer(0), m_initial_size(0)
+	{}
+	monotonic_buffer_resource(void* buffer, size_t buffer_size, memory_resource* upstream = get_default_resource())
+		: m_upstream(upstream), m_chunks(0),
+		  m_current((char*)buffer), m_end((char*)buffer + buffer_size),
+		  m_next_chunk_size(buffer_size < 64 ? 64 : 2 * buffer_size),
+		  m_initial_buffer((char*)buffer), m_initial_size(buffer_size)
+	{}
+	~monotonic_buffer_resource() { release(); }
+
+	memory_resource* upstream_resource() const { return m_upstream; }
+
+	// frees every chunk taken from upstream and rewinds to the initial buffer
+	void release()
+	{
+		while (m_chunks)
+		{
+			__chunk_header* next = m_chunks->m_next;
+			m_upstream->deallocate(m_chunks, m_chunks->m_size);
+			m_chunks = next;
+		}
+		m_current = m_initial_buffer;
+		m_end = m_initial_buffer + m_initial_size;
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t align)
+	{
+		char* p = __align_up(m_current, align);
+		if (p + bytes > m_end || p < m_current)
+		{
+			__new_chunk(bytes + align);
+			p = __align_up(m_current, align);
+		}
+		m_current = p + bytes;
+		return p;
+	}
+
+	void do_deallocate(void*, size_t, size_t) {}
+
+private:
+	enum { __INITIAL_CHUNK_SIZE = 1024 };
+
+	struct __chunk_header
+	{
+		__chunk_header* m_next;
+		size_t m_size;
+	};
+
+	memory_resource* m_upstream;
+	__chunk_header* m_chunks;
+	char* m_current;
+	char* m_end;
+	size_t m_next_chunk_size;
+	char* m_initial_buffer;
+	size_t m_initial_size;
+
+	void __new_chunk(size_t min_bytes)
+	{
+		const size_t header_size = __align_up(sizeof(__chunk_header), __DEFAULT_RESOURCE_ALIGN);
+		size_t chunk_size = m_next_chunk_size;
+		while (chunk_size < min_bytes + header_size)
+			chunk_size *= 2;
+		m_next_chunk_size = chunk_size * 2;
+
+		__chunk_header* chunk = (__chunk_header*)m_upstream->allocate(chunk_size);
+		chunk->m_next = m_chunks;
+		chunk->m_size = chunk_size;
+		m_chunks = chunk;
+		m_current = (char*)chunk + header_size;
+		m_end = (char*)chunk + chunk_size;
+	}
+
+	// not copyable
+	monotonic_buffer_resource(const monotonic_buffer_resource&);
+	monotonic_buffer_resource& operator=(const monotonic_buffer_resource&);
+};
+
+// Single threaded pool. Requests up to __MAX_POOLED_BYTES are rounded up to
+// a power of two and served from a free list per size class, refilled from
+// chunks taken from upstream; larger requests go straight to upstream and
+// are tracked so that release() can free them as well.
+class unsynchronized_pool_resource : public memory_resource
+{
+public:
+	explicit unsynchronized_pool_resource(memory_resource* upstream = get_default_resource())
+		: m_upstream(upstream), m_chunks(0), m_large_blocks(0)
+	{
+		for (int i = 0; i < __NUM_POOLS; ++i)
+		{
+			m_free_list[i] = 0;
+			m_blocks_per_chunk[i] = __MIN_BLOCKS_PER_CHUNK;
+		}
+	}
+	~unsynchronized_pool_resource() { release(); }
+
+	memory_resource* upstream_resource() const { return m_upstream; }
+
+	void release()
+	{
+		while (m_chunks)
+		{
+			__chunk_header* next = m_chunks->m_next;
+			m_upstream->deallocate(m_chunks, m_chunks->m_size);
+			m_chunks = next;
+		}
+		while (m_large_blocks)
+		{
+			__large_header* next = m_large_blocks->m_next;
+			m_upstream->deallocate(m_large_blocks, m_large_blocks->m_size, m_large_blocks->m_align);
+			m_large_blocks = next;
+		}
+		for (int i = 0; i < __NUM_POOLS; ++i)
+		{
+			m_free_list[i] = 0;
+			m_blocks_per_chunk[i] = __MIN_BLOCKS_PER_CHUNK;
+		}
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t align)
+	{
+		int index = __pool_index(bytes, align);
+		if (index < 0)
+			return __allocate_large(bytes, align);
+
+		__free_block* result = m_free_list[index];
+		if (result == 0)
+		{
+			__refill(index);
+			result = m_free_list[index];
+		}
+		m_free_list[index] = result->m_next;
+		return result;
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t align)
+	{
+		if (p == 0)
+			return;
+		int index = __pool_index(bytes, align);
+		if (index < 0)
+		{
+			__deallocate_large(p, align);
+			return;
+		}
+		__free_block* q = (__free_block*)p;
+		q->m_next = m_free_list[index];
+		m_free_list[index] = q;
+	}
+
+private:
+	enum { __MIN_POOLED_SHIFT = 3 };
+	enum { __NUM_POOLS = 10 };
+	enum { __MAX_POOLED_BYTES = 1 << (__MIN_POOLED_SHIFT + __NUM_POOLS - 1) };
+	enum { __MIN_BLOCKS_PER_CHUNK = 16 };
+	enum { __MAX_BLOCKS_PER_CHUNK = 4096 };
+
+	struct __free_block
+	{
+		__free_block* m_next;
+	};
+
+	struct __chunk_header
+	{
+		__chunk_header* m_next;
+		size_t m_size;
+	};
+
+	struct __large_header
+	{
+		__large_header* m_prev;
+		__large_header* m_next;
+		size_t m_size;
+		size_t m_align;
+	};
+
+	memory_resource* m_upstream;
+	__chunk_header* m_chunks;
+	__large_header* m_large_blocks;
+	__free_block* m_free_list[__NUM_POOLS];
+	size_t m_blocks_per_chunk[__NUM_POOLS];
+
+	static size_t __pool_block_size(int index)
+	{
+		return size_t(1) << (index + __MIN_POOLED_SHIFT);
+	}
+
+	// blocks are carved at multiples of their size from a chunk aligned to
+	// __DEFAULT_RESOURCE_ALIGN, so bumping the size class up to 'align' is
+	// enough to honour the alignment. -1 means 'not pooled'.
+	static int __pool_index(size_t bytes, size_t align)
+	{
+		if (bytes < align)
+			bytes = align;
+		if (bytes > (size_t)__MAX_POOLED_BYTES || align > (size_t)__DEFAULT_RESOURCE_ALIGN)
+			return -1;
+		int index = 0;
+		while (__pool_block_size(index) < bytes)
+			++index;
+		return index;
+	}
+
+	void __refill(int index)
+	{
+		const size_t header_size = __align_up(sizeof(__chunk_header), __DEFAULT_RESOURCE_ALIGN);
+		const size_t block_size = __pool_block_size(index);
+		const size_t nblocks = m_blocks_per_chunk[index];
+		if (nblocks < (size_t)__MAX_BLOCKS_PER_CHUNK)
+			m_blocks_per_chunk[index] = nblocks * 2;
+
+		const size_t first_offset = __align_up(header_size, block_size < (size_t)__DEFAULT_RESOURCE_ALIGN ?
+												block_size : (size_t)__DEFAULT_RESOURCE_ALIGN);
+		const size_t chunk_size = first_offset + nblocks * block_size;
+		__chunk_header* chunk = (__chunk_header*)m_upstream->allocate(chunk_size);
+		chunk->m_next = m_chunks;
+		chunk->m_size = chunk_size;
+		m_chunks = chunk;
+
+		char* p = (char*)chunk + first_offset;
+		__free_block* head = m_free_list[index];
+		for (size_t i = nblocks; i > 0; --i)
+		{
+			__free_block* b = (__free_block*)(p + (i - 1) * block_size);
+			b->m_next = head;
+			head = b;
+		}
+		m_free_list[index] = head;
+	}
+
+	void* __allocate_large(size_t bytes, size_t align)
+	{
+		if (align < (size_t)__DEFAULT_RESOURCE_ALIGN)
+			align = __DEFAULT_RESOURCE_ALIGN;
+		const size_t header_size = __align_up(sizeof(__large_header), align);
+		__large_header* h = (__large_header*)m_upstream->allocate(header_size + bytes, align);
+		h->m_prev = 0;
+		h->m_next = m_large_blocks;
+		h->m_size = header_size + bytes;
+		h->m_align = align;
+		if (m_large_blocks)
+			m_large_blocks->m_prev = h;
+		m_large_blocks = h;
+		return (char*)h + header_size;
+	}
+
+	void __deallocate_large(void* p, size_t align)
+	{
+		if (align < (size_t)__DEFAULT_RESOURCE_ALIGN)
+			align = __DEFAULT_RESOURCE_ALIGN;
+		const size_t header_size = __align_up(sizeof(__large_header), align);
+		__large_header* h = (__large_header*)((char*)p - header_size);
+		if (h->m_prev)
+			h->m_prev->m_next = h->m_next;
+		else
+			m_large_blocks = h->m_next;
+		if (h->m_next)
+			h->m_next->m_prev = h->m_prev;
+		m_upstream->deallocate(h, h->m_size, h->m_align);
+	}
+
+	// not copyable
+	unsynchronized_pool_resource(const unsynchronized_pool_resource&);
+	unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&);
+};
+
+// Stateful counterpart of type_allocator: same interface, but every
+// instance carries the memory_resource it allocates from. Containers keep
+// a copy and hand it on to the allocators they rebind from it.
+template <class T>
+class polymorphic_allocator
+{
+public:
+	typedef T value_type;
+
+	template <class U>
+	struct rebind
+	{
+		typedef polymorphic_allocator<U> other;
+	};
+
+	polymorphic_allocator() : m_resource(get_default_resource()) {}
+	polymorphic_allocator(memory_resource* r) : m_resource(r) {}
+	template <class U>
+	polymorphic_allocator(const polymorphic_allocator<U>& other) : m_resource(other.resource()) {}
+
+	T* allocate(void)
+	{
+		return (T*)m_resource->allocate(sizeof(T), __MYSTL_ALIGNOF(T));
+	}
+
+	T* allocate(size_t n)
+	{
+		return n == 0? 0 : (T*)m_resource->allocate(n * sizeof(T), __MYSTL_ALIGNOF(T));
+	}
+
+	// see type_allocator, resources hand out one block at a time
+	T* allocate_chain(size_t n)
+	{
+		void* head = 0;
+		for ( ; n > 0; --n)
+		{
+			void* p = allocate();
+			*(void**)p = head;
+			head = p;
+		}
+		return (T*)head;
+	}
+
+	void deallocate(T* p)
+	{
+		if (p)
+			m_resource->deallocate(p, sizeof(T), __MYSTL_ALIGNOF(T));
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		if (p)
+			m_resource->deallocate(p, n * sizeof(T), __MYSTL_ALIGNOF(T));
+	}
+
+	// resources cannot resize a block, so this is allocate + memcpy +
+	// deallocate; only for trivially relocatable T
+	T* reallocate(T* p, size_t old_n, size_t new_n)
+	{
+		T* result = allocate(new_n);
+		if (p)
+		{
+			memcpy(result, p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+			deallocate(p, old_n);
+		}
+		return result;
+	}
+
+	bool try_expand_in_place(T*, size_t, size_t) { return false; }
+
+	memory_resource* resource() const { return m_resource; }
+
+private:
+	memory_resource* m_resource;
+};
+
+template <class T1, class T2>
+inline bool operator==(const polymorphic_allocator<T1>& a, const polymorphic_allocator<T2>& b)
+{
+	return *a.resource() == *b.resource();
+}
+
+template <class T1, class T2>
+inline bool operator!=(const polymorphic_allocator<T1>& a, const polymorphic_allocator<T2>& b)
+{
+	return !(a == b);
+}
+
+__NS_END
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "algo_base.h"
+#include "type_traits.h"
+
+__NS_BEGIN
+
+// Sorting a long chain by following its links misses the cache on almost
+// every node. From this many nodes on, the list sorts collect the node
+// pointers in an array, sort the array and link the nodes again in its
+// order. The elements are neither copied nor moved either way.
+enum { __node_array_sort_threshold = 1024 };
+
+// orders nodes by their 'm_data'
+template <class Node>
+struct __node_data_less
+{
+	bool operator()(const Node* a, const Node* b) const { return a->m_data < b->m_data; }
+};
+
+// stable merge of two sorted ranges into 'result', on ties the element of
+// the first range comes first
+template <class T, class Compare>
+T* __merge_arrays(const T* first1, const T* last1, const T* first2, const T* last2, T* result, Compare comp)
+{
+	while (first1 != last1 && first2 != last2)
+	{
+		if (comp(*first2, *first1))
+			*result++ = *first2++;
+		else
+			*result++ = *first1++;
+	}
+	while (first1 != last1)
+		*result++ = *first1++;
+	while (first2 != last2)
+		*result++ = *first2++;
+	return result;
+}
+
+// stable bottom up merge sort of a[0, n) for trivially copyable T, 'buf'
+// is scratch space for n elements
+template <class T, class Compare>
+void __stable_sort_array(T* a, T* buf, size_t n, Compare comp)
+{
+	enum { __run = 16 };
+	for (size_t lo = 0; lo < n; lo += __run)
+	{
+		size_t hi = MySTL::min(lo + (size_t)__run, n);
+		for (size_t i = lo + 1; i < hi; ++i)
+		{
+			T x = a[i];
+			size_t j = i;
+			for ( ; j > lo && comp(x, a[j - 1]); --j)
+				a[j] = a[j - 1];
+			a[j] = x;
+		}
+	}
+	T* from = a;
+	T* to = buf;
+	for (size_t width = __run; width < n; width *= 2)
+	{
+		for (size_t lo = 0; lo < n; lo += 2 * width)
+		{
+			size_t mid = MySTL::min(lo + width, n);
+			size_t hi = MySTL::min(lo + 2 * width, n);
+			__merge_arrays(from + lo, from + mid, from + mid, from + hi, to + lo, comp);
+		}
+		MySTL::swap(from, to);
+	}
+	if (from != a)
+		memcpy(a, from, n * sizeof(T));
+}
+
+// a node with its element turned into an unsigned key, sorting these does
+// not touch the nodes at all
+template <class Node>
+struct __radix_item
+{
+	size_t m_key;
+	Node* m_node;
+};
+
+template <class Node>
+struct __radix_item_less
+{
+	bool operator()(const __radix_item<Node>& a, const __radix_item<Node>& b) const { return a.m_key < b.m_key; }
+};
+
+// maps an integer to an unsigned key of the same width and the same order
+template <class Tp>
+inline size_t __radix_key(Tp x)
+{
+	size_t key = (size_t)x;
+	if (Tp(0) > Tp(-1))
+		key ^= size_t(1) << (sizeof(Tp) * 8 - 1);
+	return key & (~size_t(0) >> ((sizeof(size_t) - sizeof(Tp)) * 8));
+}
+
+// stable LSD radix sort on the low 'key_bytes' bytes of the keys, a byte
+// every key shares costs no pass; 'buf' is scratch space for n items
+template <class Node>
+void __radix_sort_items(__radix_item<Node>* a, __radix_item<Node>* buf, size_t n, size_t key_bytes)
+{
+	typedef __radix_item<Node> Item;
+	size_t counts[sizeof(size_t)][256];
+	memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < n; ++i)
+	{
+		size_t key = a[i].m_key;
+		for (size_t b = 0; b < key_bytes; ++b, key >>= 8)
+			++counts[b][key & 255];
+	}
+	Item* from = a;
+	Item* to = buf;
+	for (size_t b = 0; b < key_bytes; ++b)
+	{
+		size_t* count = counts[b];
+		size_t shift = b * 8;
+		if (count[(from[0].m_key >> shift) & 255] == n)
+			continue;
+		size_t offset = 0;
+		for (size_t d = 0; d < 256; ++d)
+		{
+			size_t c = count[d];
+			count[d] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < n; ++i)
+			to[count[(from[i].m_key >> shift) & 255]++] = from[i];
+		MySTL::swap(from, to);
+	}
+	if (from != a)
+		memcpy(a, from, n * sizeof(Item));
+}
+
+// sorts the arrays on the calling thread
+struct __serial_sort_engine
+{
+	template <class T, class Compare>
+	void __sort(T* a, T* buf, size_t n, Compare comp) const { __stable_sort_array(a, buf, n, comp); }
+
+	template <class Node>
+	void __sort_keys(__radix_item<Node>* a, __radix_item<Node>* buf, size_t n, size_t key_bytes) const
+	{
+		__radix_sort_items(a, buf, n, key_bytes);
+	}
+};
+
+#if defined(__MYSTL_CXX11)
+class thread_pool;
+
+// in thread_pool.h
+template <class T, class Compare>
+void __parallel_stable_sort_array(thread_pool& pool, T* a, T* buf, size_t n, Compare comp);
+template <class Node>
+void __parallel_radix_sort_items(thread_pool& pool, __radix_item<Node>* a, __radix_item<Node>* buf, size_t n, size_t key_bytes);
+
+// sorts the arrays on the workers of a pool
+struct __parallel_sort_engine
+{
+	thread_pool* m_pool;
+
+	explicit __parallel_sort_engine(thread_pool& pool) : m_pool(&pool) {}
+
+	template <class T, class Compare>
+	void __sort(T* a, T* buf, size_t n, Compare comp) const { __parallel_stable_sort_array(*m_pool, a, buf, n, comp); }
+
+	template <class Node>
+	void __sort_keys(__radix_item<Node>* a, __radix_item<Node>* buf, size_t n, size_t key_bytes) const
+	{
+		__parallel_radix_sort_items(*m_pool, a, buf, n, key_bytes);
+	}
+};
+#endif
+
+// The scratch arrays come from malloc rather than an allocator, which
+// would throw: without memory the caller falls back to sorting the links
+// and a list sort still cannot fail.
+
+// sorts the node pointers a[0, n) stably, false when out of memory
+template <class Node, class Compare, class Engine>
+bool __sort_node_pointers(Node** a, size_t n, Compare comp, Engine engine)
+{
+	Node** buf = (Node**)malloc(n * sizeof(Node*));
+	if (buf == 0)
+		return false;
+	engine.__sort(a, buf, n, comp);
+	free(buf);
+	return true;
+}
+
+template <class Node, class Compare, class Engine>
+bool __sort_node_array(Node** a, size_t n, Compare comp, Engine engine)
+{
+	return __sort_node_pointers(a, n, comp, engine);
+}
+
+// integers in their natural order are radix sorted on a copy of their
+// keys, other elements are compared through the node pointers
+template <class Node, class Engine>
+bool __sort_node_array(Node** a, size_t n, __node_data_less<Node> comp, Engine engine)
+{
+	return __sort_node_data(a, n, comp, engine, &a[0]->m_data);
+}
+
+template <class Node, class Engine, class Tp>
+bool __sort_node_data(Node** a, size_t n, __node_data_less<Node> comp, Engine engine, const Tp*)
+{
+	typedef typename is_integer<Tp>::integer is_int;
+	return __sort_node_data(a, n, comp, engine, (const Tp*)0, is_int());
+}
+
+template <class Node, class Engine, class Tp>
+bool __sort_node_data(Node** a, size_t n, __node_data_less<Node> comp, Engine engine, const Tp*, false_type)
+{
+	return __sort_node_pointers(a, n, comp, engine);
+}
+
+template <class Node, class Engine, class Tp>
+bool __sort_node_data(Node** a, size_t n, __node_data_less<Node> comp, Engine engine, const Tp*, true_type)
+{
+	typedef __radix_item<Node> Item;
+	if (sizeof(Tp) > sizeof(size_t))
+		return __sort_node_pointers(a, n, comp, engine);
+	Item* items = (Item*)malloc(2 * n * sizeof(Item));
+	if (items == 0)
+		return __sort_node_pointers(a, n, comp, engine);
+	for (size_t i = 0; i < n; ++i)
+	{
+		items[i].m_key = __radix_key(a[i]->m_data);
+		items[i].m_node = a[i];
+	}
+	engine.__sort_keys(items, items + n, n, sizeof(Tp));
+	for (size_t i = 0; i < n; ++i)
+		a[i] = items[i].m_node;
+	free(items);
+	return true;
+}
+
+__NS_END
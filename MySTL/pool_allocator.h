@@ -0,0 +1,345 @@
+#pragma once
+
+#include "config.h"
+#include "allocator.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+__NS_BEGIN
+
+// Spin lock for the short critical sections of a shared pool. It is a
+// plain zero initialized integer, so a pool may be used from the static
+// constructors of other translation units.
+struct __spin_lock
+{
+#if defined(_WIN32)
+	volatile LONG m_locked;
+
+	void __acquire()
+	{
+		while (InterlockedExchange(&m_locked, 1) != 0)
+			Sleep(0);
+	}
+	void __release() { InterlockedExchange(&m_locked, 0); }
+#else
+	volatile int m_locked;
+
+	void __acquire()
+	{
+		while (__sync_lock_test_and_set(&m_locked, 1) != 0)
+			sched_yield();
+	}
+	void __release() { __sync_lock_release(&m_locked); }
+#endif
+};
+
+// Size-class node allocator. Requests up to __MAX_BYTES are rounded up to a
+// multiple of __ALIGN and served from one free list per size class; the free
+// lists are refilled __NOBJS objects at a time from large chunks obtained
+// from 'allocator'. Chunks are never given back, freed objects go back to
+// their free list. Larger requests are forwarded to 'allocator'.
+//
+// Objects of a size class that is a multiple of __MALLOC_ALIGN start on
+// that alignment, so a node is aligned like a malloc block whenever its type
+// needs it. Over-aligned types go to 'allocator'.
+//
+// With 'threads' set the free lists are shared under a spin lock, like the
+// SGI node allocator. Without it every container using the pool has to
+// stay on one thread.
+template <bool threads, int inst>
+class __pool_alloc_template
+{
+private:
+	enum { __ALIGN = 8 };
+	enum { __MAX_BYTES = 128 };
+	enum { __NFREELISTS = __MAX_BYTES / __ALIGN };
+	enum { __NOBJS = 20 };
+
+	union __obj
+	{
+		union __obj* m_free_list_link;
+		char m_client_data[1];
+	};
+
+	static __obj* s_free_list[__NFREELISTS];
+	static char* s_start_free;
+	static char* s_end_free;
+	static size_t s_heap_size;
+	static __spin_lock s_lock;
+
+	// holds the pool lock until the end of the scope
+	struct __lock
+	{
+		__lock() { if (threads) s_lock.__acquire(); }
+		~__lock() { if (threads) s_lock.__release(); }
+	};
+
+	static size_t __round_up(size_t bytes)
+	{
+		return (bytes + __ALIGN - 1) & ~(size_t(__ALIGN) - 1);
+	}
+
+	static size_t __freelist_index(size_t bytes)
+	{
+		return (bytes + __ALIGN - 1) / __ALIGN - 1;
+	}
+
+	static void* __refill(size_t n);
+	static char* __chunk_alloc(size_t size, int& nobjs);
+
+	static void __push_free(char* p, size_t bytes)
+	{
+		__obj** my_free_list = s_free_list + __freelist_index(bytes);
+		((__obj*)p)->m_free_list_link = *my_free_list;
+		*my_free_list = (__obj*)p;
+	}
+
+	// hands the unused end of a chunk to the free lists; a piece that would
+	// be a misaligned object of its class gives its first __ALIGN bytes to
+	// the smallest class
+	static void __free_leftover(char* p, size_t bytes)
+	{
+		if (bytes == 0)
+			return;
+		if (bytes % __MALLOC_ALIGN == 0 && (size_t)p % __MALLOC_ALIGN != 0)
+		{
+			__push_free(p, __ALIGN);
+			p += __ALIGN;
+			bytes -= __ALIGN;
+		}
+		if (bytes != 0)
+			__push_free(p, bytes);
+	}
+
+	// moves the start of the current chunk to the alignment of objects of
+	// 'n' bytes, which is __MALLOC_ALIGN for multiples of it
+	static void __align_start_free(size_t n)
+	{
+		if (n % __MALLOC_ALIGN != 0 || (size_t)s_start_free % __MALLOC_ALIGN == 0)
+			return;
+		if (s_end_free - s_start_free >= (ptrdiff_t)__ALIGN)
+		{
+			__push_free(s_start_free, __ALIGN);
+			s_start_free += __ALIGN;
+		}
+	}
+
+	// links 'count' adjacent objects of 'n' bytes at 'p' in front of 'next'
+	static void* __link_objects(char* p, size_t n, size_t count, void* next)
+	{
+		for (size_t i = count; i > 0; --i)
+		{
+			char* obj = p + (i - 1) * n;
+			*(void**)obj = next;
+			next = obj;
+		}
+		return next;
+	}
+
+public:
+	static void* allocate(size_t n)
+	{
+		if (n == 0)
+			return 0;
+		if (n > (size_t)__MAX_BYTES)
+			return allocator::allocate(n);
+
+		__lock guard;
+		__obj** my_free_list = s_free_list + __freelist_index(n);
+		__obj* result = *my_free_list;
+		if (result == 0)
+			return __refill(__round_up(n));
+		*my_free_list = result->m_free_list_link;
+		return result;
+	}
+
+	// Small objects are carved side by side from the rest of the current
+	// chunk and, for the others, one new chunk of just the right size plus
+	// the usual growth, so a bulk insertion of a million nodes costs one
+	// allocation and its nodes are adjacent in memory.
+	static void* allocate_chain(size_t n, size_t count)
+	{
+		if (count == 0)
+			return 0;
+		if (n > (size_t)__MAX_BYTES)
+			return allocator::allocate_chain(n, count);
+
+		__lock guard;
+		n = __round_up(n);
+		__align_start_free(n);
+		size_t bytes_left = s_end_free - s_start_free;
+		size_t head_count = bytes_left / n < count ? bytes_left / n : count;
+		char* head = s_start_free;
+		void* rest = 0;
+		if (head_count < count)
+		{
+			// the new chunk comes first, if it throws the pool is unchanged
+			size_t rest_bytes = (count - head_count) * n;
+			size_t bytes_to_get = rest_bytes + __round_up(s_heap_size >> 4);
+			char* chunk = (char*)allocator::allocate(bytes_to_get);
+			__free_leftover(head + head_count * n, bytes_left - head_count * n);
+			s_heap_size += bytes_to_get;
+			s_start_free = chunk + rest_bytes;
+			s_end_free = chunk + bytes_to_get;
+			rest = __link_objects(chunk, n, count - head_count, 0);
+		}
+		else
+			s_start_free += head_count * n;
+		return __link_objects(head, n, head_count, rest);
+	}
+
+	static void deallocate(void* p, size_t n)
+	{
+		if (p == 0)
+			return;
+		if (n > (size_t)__MAX_BYTES)
+		{
+			allocator::deallocate(p, n);
+			return;
+		}
+
+		__lock guard;
+		__obj* q = (__obj*)p;
+		__obj** my_free_list = s_free_list + __freelist_index(n);
+		q->m_free_list_link = *my_free_list;
+		*my_free_list = q;
+	}
+
+	// over-aligned objects do not come from the pool
+	static void* allocate(size_t n, size_t align) { return allocator::allocate(n, align); }
+	static void deallocate(void* p, size_t n, size_t align) { allocator::deallocate(p, n, align); }
+	static void* reallocate(void* p, size_t old_n, size_t new_n, size_t align)
+	{
+		return allocator::reallocate(p, old_n, new_n, align);
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n)
+	{
+		if (p && old_n > (size_t)__MAX_BYTES && new_n > (size_t)__MAX_BYTES)
+			return allocator::reallocate(p, old_n, new_n);
+		if (try_expand_in_place(p, old_n, new_n))
+			return p;
+		void* result = allocate(new_n);
+		if (p)
+		{
+			memcpy(result, p, old_n < new_n ? old_n : new_n);
+			deallocate(p, old_n);
+		}
+		return result;
+	}
+
+	// an object can grow up to the end of its size class
+	static bool try_expand_in_place(void* p, size_t old_n, size_t new_n)
+	{
+		if (p == 0 || new_n == 0)
+			return false;
+		if (old_n > (size_t)__MAX_BYTES)
+			return new_n > (size_t)__MAX_BYTES && allocator::try_expand_in_place(p, old_n, new_n);
+		return new_n <= (size_t)__MAX_BYTES && __round_up(new_n) == __round_up(old_n);
+	}
+};
+
+// returns one object of size 'n' and puts the rest of the refilled objects
+// into the free list. 'n' is already rounded up.
+template <bool threads, int inst>
+void* __pool_alloc_template<threads, inst>::__refill(size_t n)
+{
+	int nobjs = __NOBJS;
+	char* chunk = __chunk_alloc(n, nobjs);
+	if (nobjs == 1)
+		return chunk;
+
+	__obj** my_free_list = s_free_list + __freelist_index(n);
+	__obj* result = (__obj*)chunk;
+	__obj* next_obj = (__obj*)(chunk + n);
+	*my_free_list = next_obj;
+	for (int i = 1; ; ++i)
+	{
+		__obj* current_obj = next_obj;
+		next_obj = (__obj*)((char*)next_obj + n);
+		if (i == nobjs - 1)
+		{
+			current_obj->m_free_list_link = 0;
+			break;
+		}
+		current_obj->m_free_list_link = next_obj;
+	}
+	return result;
+}
+
+// carves 'nobjs' objects of 'size' bytes from the current chunk, 'nobjs' is
+// lowered if the chunk only has room for fewer. When not even one object
+// fits, the leftover is handed to its free list and a new chunk is fetched.
+template <bool threads, int inst>
+char* __pool_alloc_template<threads, inst>::__chunk_alloc(size_t size, int& nobjs)
+{
+	__align_start_free(size);
+	char* result;
+	size_t total_bytes = size * nobjs;
+	size_t bytes_left = s_end_free - s_start_free;
+
+	if (bytes_left >= total_bytes)
+	{
+		result = s_start_free;
+		s_start_free += total_bytes;
+		return result;
+	}
+	else if (bytes_left >= size)
+	{
+		nobjs = (int)(bytes_left / size);
+		total_bytes = size * nobjs;
+		result = s_start_free;
+		s_start_free += total_bytes;
+		return result;
+	}
+	else
+	{
+		size_t bytes_to_get = 2 * total_bytes + __round_up(s_heap_size >> 4);
+		__free_leftover(s_start_free, bytes_left);
+		s_start_free = (char*)allocator::allocate(bytes_to_get);
+		s_heap_size += bytes_to_get;
+		s_end_free = s_start_free + bytes_to_get;
+		return __chunk_alloc(size, nobjs);
+	}
+}
+
+template <bool threads, int inst>
+typename __pool_alloc_template<threads, inst>::__obj*
+__pool_alloc_template<threads, inst>::s_free_list[__pool_alloc_template<threads, inst>::__NFREELISTS] = { 0 };
+
+template <bool threads, int inst>
+char* __pool_alloc_template<threads, inst>::s_start_free = 0;
+
+template <bool threads, int inst>
+char* __pool_alloc_template<threads, inst>::s_end_free = 0;
+
+template <bool threads, int inst>
+size_t __pool_alloc_template<threads, inst>::s_heap_size = 0;
+
+template <bool threads, int inst>
+__spin_lock __pool_alloc_template<threads, inst>::s_lock = { 0 };
+
+// pool_allocator is the default node allocator of list, slist, hashtable,
+// RB_tree and AVL_tree. Its lock makes containers on different threads
+// safe to use at the same time, and a node may be freed on another thread
+// than the one that allocated it; one container shared between threads
+// still needs the caller's own locking, as with any allocator. All
+// threads take turns on the one spin lock, so programs that churn nodes
+// on many threads at once are better served by thread_cache_allocator.
+// Chunks are kept until the process exits.
+//
+// single_client_pool_allocator has no lock and is several times faster;
+// it is opt-in, as in list<int, type_allocator<__list_node<int>,
+// single_client_pool_allocator> >, for containers that never leave their
+// thread.
+typedef __pool_alloc_template<true, 0> pool_allocator;
+typedef __pool_alloc_template<false, 0> single_client_pool_allocator;
+
+__NS_END
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "algo_base.h"
+#include "pair.h"
+#include "inplace_vector.h"
 #include "stack.h"
 
 __NS_BEGIN
@@ -34,15 +36,25 @@ void quick_sort_recursive(Iterator a, int lo, int hi)
 template<class Iterator>
 void quick_sort_nonrecursive(Iterator a, int lo, int hi)
 {
-	stack<pair<int, int> > s;
+	// the larger side waits on the stack, so it never holds more than
+	// log2(n) ranges and can live in a fixed buffer
+	stack<pair<int, int>, inplace_vector<pair<int, int>, 32> > s;
 	int mid = 0;
 	while (lo < hi || !s.empty())
 	{
 		if (lo < hi)
 		{
 			int mid = partition(a, lo, hi);
-			s.push(make_pair(mid, hi));
-			hi = mid - 1;
+			if (mid - lo < hi - mid)
+			{
+				s.push(make_pair(mid, hi));
+				hi = mid - 1;
+			}
+			else
+			{
+				s.push(make_pair(lo - 1, mid - 1));
+				lo = mid + 1;
+			}
 		}
 		else
 		{
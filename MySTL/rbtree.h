@@ -4,6 +4,7 @@
 #include "type_traits.h"
 #include "iterator_base.h"
 #include "algo_base.h"
+#include "pool_allocator.h"
 #include "stack.h"
 
 #include <string>
@@ -153,7 +154,7 @@ struct __RB_tree_iterator
 
 template <class Key, class Value, 
           class ExtractKey, class KeyCompare,
-		  class Alloc = type_allocator<__RB_tree_node<Value> > >
+		  class Alloc = type_allocator<__RB_tree_node<Value>, pool_allocator> >
 class RB_tree
 {
 public:
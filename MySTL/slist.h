@@ -2,7 +2,9 @@
 
 #include "algo_base.h"
 #include "allocator.h"
+#include "pool_allocator.h"
 #include "initialize.h"
+#include "node_sort.h"
 
 __NS_BEGIN
 
@@ -13,46 +15,49 @@ struct __slist_node
 	__slist_node* m_next;
 };
 
-template <class T>
-__slist_node<T>* __slist_make_link(__slist_node<T>* prev_node, __slist_node<T>* new_node)
+// The helpers below work on any node type with an 'm_next' member, so the
+// intrusive lists and list::sort share them.
+
+template <class Node>
+Node* __slist_make_link(Node* prev_node, Node* new_node)
 {
 	new_node->m_next = prev_node->m_next;
 	prev_node->m_next = new_node;
 	return new_node;
 }
 
-template <class T>
-__slist_node<T>* __slist_previous(__slist_node<T>* head, const __slist_node<T>* node)
+template <class Node>
+Node* __slist_previous(Node* head, const Node* node)
 {
 	while (head && head->m_next != node)
 		head = head->m_next;
 	return head;
 }
 
-template <class T>
-const __slist_node<T>* __slist_previous(const __slist_node<T>* head, const __slist_node<T>* node)
+template <class Node>
+const Node* __slist_previous(const Node* head, const Node* node)
 {
 	while (head && head->m_next != node)
 		head = head->m_next;
 	return head;
 }
 
-template <class T>
-void __slist_splice_after(__slist_node<T>* pos, __slist_node<T>* before_first, __slist_node<T>* before_last)
+template <class Node>
+void __slist_splice_after(Node* pos, Node* before_first, Node* before_last)
 {
 	if (pos != before_first && pos != before_last) 
 	{
-		__slist_node<T>* first = before_first->m_next;
+		Node* first = before_first->m_next;
 		before_first->m_next = before_last->m_next;
 		before_last->m_next = pos->m_next;
 		pos->m_next = first;
 	}
 }
 
-template <class T>
-void __slist_splice_after(__slist_node<T>* pos, __slist_node<T>* head)
+template <class Node>
+void __slist_splice_after(Node* pos, Node* head)
 {
-	__slist_node<T>* before_last = __slist_previous(head, (__slist_node<T>*)0);
+	Node* before_last = __slist_previous(head, (Node*)0);
 	if (before_last != head) 
 	{
 		before_last->m_next = pos->m_next;
@@ -61,13 +66,13 @@ void __slist_splice_after(__slist_node<T>* pos, __slist_node<T>* head)
 	}
 }
 
-template <class T>
-__slist_node<T>* __slist_reverse(__slist_node<T>* node)
+template <class Node>
+Node* __slist_reverse(Node* node)
 {
-	__slist_node<T>* result = 0;
+	Node* result = 0;
 	while(node) 
 	{
-		__slist_node<T>* next = node->m_next;
+		Node* next = node->m_next;
 		node->m_next = result;
 		result = node;
 		node = next;
@@ -75,8 +80,8 @@ __slist_node<T>* __slist_reverse(__slist_node<T>* node)
 	return result;
 }
 
-template <class T>
-size_t __slist_size(__slist_node<T>* node)
+template <class Node>
+size_t __slist_size(Node* node)
 {
 	size_t result = 0;
 	for ( ; node != 0; node = node->m_next)
@@ -84,6 +89,97 @@ size_t __slist_size(__slist_node<T>* node)
 	return result;
 }
 
+// stable merge of the null terminated sorted chains 'a' and 'b', on ties
+// the node of 'a' comes first
+template <class Node, class Compare>
+Node* __slist_merge_chains(Node* a, Node* b, Compare comp)
+{
+	Node* result = 0;
+	Node** tail = &result;
+	while (a && b)
+	{
+		if (comp(b, a))
+		{
+			*tail = b;
+			tail = &b->m_next;
+			b = b->m_next;
+		}
+		else
+		{
+			*tail = a;
+			tail = &a->m_next;
+			a = a->m_next;
+		}
+	}
+	*tail = a ? a : b;
+	return result;
+}
+
+// stable bottom up merge sort of a null terminated chain by its links,
+// bin i holds a sorted run of 2^i nodes or nothing
+template <class Node, class Compare>
+Node* __slist_merge_sort_chain(Node* first, Compare comp)
+{
+	Node* bins[64];
+	int fill = 0;
+	while (first)
+	{
+		Node* carry = first;
+		first = first->m_next;
+		carry->m_next = 0;
+		int i = 0;
+		for ( ; i < fill && bins[i]; ++i)
+		{
+			carry = __slist_merge_chains(bins[i], carry, comp);
+			bins[i] = 0;
+		}
+		bins[i] = carry;
+		if (i == fill)
+			++fill;
+	}
+	Node* result = 0;
+	for (int i = 0; i < fill; ++i)
+		if (bins[i])
+			result = __slist_merge_chains(bins[i], result, comp);
+	return result;
+}
+
+// stable sort of a null terminated chain: a long one through an array of
+// its node pointers sorted by 'engine', a short one by its links
+template <class Node, class Compare, class Engine>
+Node* __slist_sort_chain(Node* first, Compare comp, Engine engine)
+{
+	size_t n = 0;
+	for (Node* p = first; p != 0 && n < (size_t)__node_array_sort_threshold; p = p->m_next)
+		++n;
+	if (n < (size_t)__node_array_sort_threshold)
+		return __slist_merge_sort_chain(first, comp);
+	n = __slist_size(first);
+	Node** a = (Node**)malloc(n * sizeof(Node*));
+	if (a == 0)
+		return __slist_merge_sort_chain(first, comp);
+	Node* p = first;
+	for (size_t i = 0; i < n; ++i, p = p->m_next)
+		a[i] = p;
+	if (!__sort_node_array(a, n, comp, engine))
+	{
+		free(a);
+		return __slist_merge_sort_chain(first, comp);
+	}
+	for (size_t i = 0; i + 1 < n; ++i)
+		a[i]->m_next = a[i + 1];
+	a[n - 1]->m_next = 0;
+	first = a[0];
+	free(a);
+	return first;
+}
+
+template <class Node, class Compare>
+Node* __slist_sort_chain(Node* first, Compare comp)
+{
+	return __slist_sort_chain(first, comp, __serial_sort_engine());
+}
+
 template <class Tp, class Ref, class Ptr>
 struct __slist_iterator
 {
@@ -113,7 +209,7 @@ struct __slist_iterator
 };
 
 
-template <class Tp, class Alloc = type_allocator<__slist_node<Tp> > >
+template <class Tp, class Alloc = type_allocator<__slist_node<Tp>, pool_allocator> >
 class slist
 {
 public:
@@ -129,17 +225,33 @@ public:
 	typedef __slist_iterator<Tp, const Tp&, const Tp*>	const_iterator;
 
 	typedef __slist_node<Tp> Node;
+	typedef Alloc allocator_type;
 
 private:
 	Node m_head;
+	// the element count together with the allocator
+	__alloc_pair<Alloc, size_type> m_size;
+
+	size_type& __size() { return m_size.m_value; }
+	size_type __size() const { return m_size.m_value; }
+	Alloc& __alloc() { return m_size.__alloc(); }
+	const Alloc& __alloc() const { return m_size.__alloc(); }
 
-	Node* __get_node() { return Alloc::allocate(1); }
-	void __put_node(Node* p) { Alloc::deallocate(p, 1); }
+	Node* __get_node() { return __alloc().allocate(1); }
+	void __put_node(Node* p) { __alloc().deallocate(p, 1); }
 
 	Node* __create_node(const value_type& x) 
 	{
 		Node* node = __get_node();
-		construct(&node->m_data, x);
+		try
+		{
+			construct(&node->m_data, x);
+		}
+		catch (...)
+		{
+			__put_node(node);
+			throw;
+		}
 		node->m_next = 0;
 		return node;
 	}
@@ -151,6 +263,7 @@ private:
 		pos->m_next = next_next;
 		destruct(&next->m_data);
 		__put_node(next);
+		--__size();
 		return next_next;
 	}
 	Node* __erase_after(Node* before_first, Node* last_node)
@@ -163,6 +276,7 @@ private:
 			cur = cur->m_next;
 			destruct(&tmp->m_data);
 			__put_node(tmp);
+			--__size();
 		}
 		return last_node;
 	}
@@ -207,12 +321,60 @@ private:
 
 
 	Node* __insert_after(Node* pos, const value_type& x) 
-	{ return __slist_make_link(pos, __create_node(x)); }
+	{
+		Node* p = __slist_make_link(pos, __create_node(x));
+		++__size();
+		return p;
+	}
 
+	// bulk insertions take all their nodes from one allocate_chain() call,
+	// which the default pool_allocator carves from one chunk; every node
+	// counts once it is linked, and if a copy throws the nodes not linked
+	// yet go back to the allocator
+	void __put_chain(Node* chain, size_type n)
+	{
+		for ( ; n > 0; --n)
+		{
+			Node* p = chain;
+			chain = (Node*)__chain_next(p);
+			__put_node(p);
+		}
+	}
 	void __insert_after_fill(Node* pos, size_type n, const value_type& x) 
 	{
-		for (size_type i = 0; i < n; ++i)
-			pos = __slist_make_link(pos, __create_node(x));
+		Node* chain = __alloc().allocate_chain(n);
+		Node* next = 0;
+		size_type i = 0;
+		try
+		{
+			for ( ; i < n; ++i)
+			{
+				next = (Node*)__chain_next(chain);
+				construct(&chain->m_data, x);
+				pos = __slist_make_link(pos, chain);
+				++__size();
+				chain = next;
+			}
+		}
+		catch (...)
+		{
+			// the failed copy may have overwritten the link of its node
+			__put_node(chain);
+			__put_chain(next, n - i - 1);
+			throw;
+		}
+	}
+
+	// the nodes (before_first, before_last] of 'x' move to this list
+	void __transfer_size(slist& x, Node* before_first, Node* before_last)
+	{
+		if (&x == this)
+			return;
+		size_type n = 0;
+		for (Node* p = before_first; p != before_last; p = p->m_next)
+			++n;
+		__size() += n;
+		x.__size() -= n;
 	}
 
 	template <class Integer>
@@ -221,14 +383,45 @@ private:
 
 	template <class InputIterator>
 	void __insert_after_range_aux(Node* pos, InputIterator first, InputIterator last, false_type) 
+	{
+		__insert_after_range_aux(pos, first, last, iterator_category(first));
+	}
+
+	template <class InputIterator>
+	void __insert_after_range_aux(Node* pos, InputIterator first, InputIterator last, input_iterator_tag) 
 	{
 		while (first != last) 
 		{
-			pos = __slist_make_link(pos, __create_node(*first));
+			pos = __insert_after(pos, *first);
 			++first;
 		}
 	}
 
+	template <class ForwardIterator>
+	void __insert_after_range_aux(Node* pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag) 
+	{
+		size_type n = MySTL::distance(first, last);
+		Node* chain = __alloc().allocate_chain(n);
+		Node* next = 0;
+		try
+		{
+			for ( ; first != last; ++first, --n)
+			{
+				next = (Node*)__chain_next(chain);
+				construct(&chain->m_data, *first);
+				pos = __slist_make_link(pos, chain);
+				++__size();
+				chain = next;
+			}
+		}
+		catch (...)
+		{
+			__put_node(chain);
+			__put_chain(next, n - 1);
+			throw;
+		}
+	}
+
 	template <class InputIterator>
 	void __insert_after_range(Node* pos, InputIterator first, InputIterator last) 
 	{
@@ -237,19 +430,40 @@ private:
 	}
 
 public:
-	slist() { m_head.m_next = 0; }
-	slist(size_type n, const value_type& x) { __insert_after_fill(&this->m_head, n, x); }
-	explicit slist(size_type n) { __insert_after_fill(&this->m_head, n, value_type()); }
+	slist() : m_size(Alloc(), 0) { m_head.m_next = 0; }
+	explicit slist(const Alloc& a) : m_size(a, 0) { m_head.m_next = 0; }
+	slist(size_type n, const value_type& x, const Alloc& a = Alloc()) 
+		: m_size(a, 0)
+	{ 
+		m_head.m_next = 0;
+		__insert_after_fill(&this->m_head, n, x); 
+	}
+	explicit slist(size_type n) 
+		: m_size(Alloc(), 0)
+	{ 
+		m_head.m_next = 0;
+		__insert_after_fill(&this->m_head, n, value_type()); 
+	}
 	template <class InputIterator>
-	slist(InputIterator first, InputIterator last) { __insert_after_range(&this->m_head, first, last); }
-	slist(const slist& x) { __insert_after_range(&this->m_head, x.begin(), x.end()); }
+	slist(InputIterator first, InputIterator last, const Alloc& a = Alloc()) 
+		: m_size(a, 0)
+	{ 
+		m_head.m_next = 0;
+		__insert_after_range(&this->m_head, first, last); 
+	}
+	slist(const slist& x) 
+		: m_size(x.__alloc(), 0)
+	{ 
+		m_head.m_next = 0;
+		__insert_after_range(&this->m_head, x.begin(), x.end()); 
+	}
 	~slist() { __erase_after(&m_head, 0); }
 
 	slist& operator= (const slist& x)
 	{
 		if (&x != this) 
 		{
-			Node* p1 = m_head;
+			Node* p1 = &m_head;
 			Node* n1 = m_head.m_next;
 			Node* n2 = x.m_head.m_next;
 			while (n1 && n2) 
@@ -262,7 +476,7 @@ public:
 			if (n2 == 0)
 				__erase_after(p1, 0);
 			else
-				__insert_after_range(p1, n2, 0);
+				__insert_after_range(p1, const_iterator(n2), x.end());
 		}
 		return *this;
 	}
@@ -284,21 +498,20 @@ public:
 	const_iterator end() const { return const_iterator(0); }
 	iterator before_begin() { return iterator(&m_head); }
 	const_iterator before_begin() const { return const_iterator(&m_head); }
-	size_type size() const { return __slist_size(m_head.m_next); }
+	size_type size() const { return __size(); }
 	size_type max_size() const { return size_type(-1); }
 	bool empty() const { return m_head.m_next == 0; }
-	void swap(slist& x) { ::swap(m_head.m_next, x.m_head.m_next); }
+	void swap(slist& x) 
+	{ 
+		MySTL::swap(m_head.m_next, x.m_head.m_next); 
+		MySTL::swap(m_size, x.m_size);
+	}
+	allocator_type get_allocator() const { return __alloc(); }
 
 	reference front() { return m_head.m_next->m_data; }
 	const_reference front() const { return m_head.m_next->m_data; }
-	void push_front(const value_type& x) { __slist_make_link(&m_head, __create_node(x)); }
-	void pop_front() 
-	{
-		Node* node = m_head.m_next;
-		m_head.m_next = node->m_next;
-		destruct(&node->m_data);
-		__put_node(node);
-	}
+	void push_front(const value_type& x) { __insert_after(&m_head, x); }
+	void pop_front() { __erase_after(&m_head); }
 
 	iterator previous(const_iterator pos) 
 	{ return iterator(__slist_previous(&m_head, pos.m_node)); }
@@ -359,45 +572,68 @@ public:
 	void resize(size_type new_size, const Tp& x)
 	{
 		Node* cur = &m_head;
-		while (cur->m_next != 0 && len > 0) 
-		{
-			--len;
+		size_type len = MySTL::min(new_size, __size());
+		for ( ; len > 0; --len)
 			cur = cur->m_next;
-		}
-		if (cur->m_next) 
+		if (new_size < __size())
 			this->__erase_after(cur, 0);
 		else
-			__insert_after_fill(cur, len, x);
+			__insert_after_fill(cur, new_size - __size(), x);
 	}
 
 	void resize(size_type new_size) { resize(new_size, Tp()); }
 	void clear() { this->__erase_after(&m_head, 0); }
 
+	// The splices without a list argument move nodes within this list, the
+	// others move them from 'x' and keep both sizes; a range from another
+	// list is counted, O(n) in its length.
 	void splice_after(iterator pos, iterator before_first, iterator before_last)
 	{
 		if (before_first != before_last) 
 			__slist_splice_after(pos.m_node, before_first.m_node, before_last.m_node);
 	}
+	void splice_after(iterator pos, slist& x, iterator before_first, iterator before_last)
+	{
+		if (before_first != before_last)
+		{
+			__transfer_size(x, before_first.m_node, before_last.m_node);
+			__slist_splice_after(pos.m_node, before_first.m_node, before_last.m_node);
+		}
+	}
 	void splice_after(iterator pos, iterator prev)
 	{
 		__slist_splice_after(pos.m_node, prev.m_node, prev.m_node->m_next);
 	}
+	void splice_after(iterator pos, slist& x, iterator prev)
+	{
+		++__size();
+		--x.__size();
+		__slist_splice_after(pos.m_node, prev.m_node, prev.m_node->m_next);
+	}
 	void splice_after(iterator pos, slist& x)
 	{
 		__slist_splice_after(pos.m_node, &x.m_head);
+		__size() += x.__size();
+		x.__size() = 0;
 	}
 
 	void splice(iterator pos, slist& x) 
 	{
 		if (x.m_head.m_next)
+		{
 			__slist_splice_after(
 				__slist_previous(&m_head, pos.m_node), 
 				&x.m_head, 
 				__slist_previous(&x.m_head, (Node*)0)
 				);
+			__size() += x.__size();
+			x.__size() = 0;
+		}
 	}
 	void splice(iterator pos, slist& x, iterator i) 
 	{
+		++__size();
+		--x.__size();
 		__slist_splice_after(
 			__slist_previous(&this->m_head, pos.m_node),
 			__slist_previous(&x.m_head, i.m_node),
@@ -407,11 +643,16 @@ public:
 	void splice(iterator pos, slist& x, iterator first, iterator last)
 	{
 		if (first != last)
+		{
+			Node* before_first = __slist_previous(&x.m_head, first.m_node);
+			Node* before_last = __slist_previous(first.m_node, last.m_node);
+			__transfer_size(x, before_first, before_last);
 			__slist_splice_after(
-			__slist_previous(&this->m_head, pos.m_node),
-			__slist_previous(&x.m_head, first.m_node),
-			__slist_previous(first.m_node, last.m_node)
-			);
+				__slist_previous(&this->m_head, pos.m_node),
+				before_first,
+				before_last
+				);
+		}
 	}
 
 	void reverse() 
@@ -449,47 +690,26 @@ public:
 
 	void merge(slist& x)
 	{
-		Node* n1 = &m_head;
-		while (n1->m_next && x.m_head.m_next) 
-		{
-			if (x.m_head.m_next->m_data < n1->m_next->m_data) 
-				__slist_splice_after(n1, &x.m_head, x.m_head.m_next);
-			n1 = n1->m_next;
-		}
-		if (x.m_head.m_next) 
-		{
-			n1->m_next = x.m_head.m_next;
-			x.m_head.m_next = 0;
-		}
+		if (&x == this)
+			return;
+		m_head.m_next = __slist_merge_chains(m_head.m_next, x.m_head.m_next, __node_data_less<Node>());
+		x.m_head.m_next = 0;
+		__size() += x.__size();
+		x.__size() = 0;
 	}
 
 	void sort()
 	{
-		if (this->m_head.m_next && this->m_head.m_next->m_next) 
-		{
-			slist carry;
-			slist counter[64];
-			int fill = 0;
-			while (!empty()) 
-			{
-				__slist_splice_after(&carry.m_head, &m_head, m_head.m_next);
-				int i = 0;
-				while (i < fill && !counter[i].empty()) 
-				{
-					counter[i].merge(carry);
-					carry.swap(counter[i]);
-					++i;
-				}
-				carry.swap(counter[i]);
-				if (i == fill)
-					++fill;
-			}
-
-			for (int i = 1; i < fill; ++i)
-				counter[i].merge(counter[i-1]);
-			this->swap(counter[fill-1]);
-		}
+		m_head.m_next = __slist_sort_chain(m_head.m_next, __node_data_less<Node>());
+	}
+#if defined(__MYSTL_CXX11)
+	// the same order as sort(), a long list is sorted on the workers of
+	// 'pool' (thread_pool.h)
+	void sort(thread_pool& pool)
+	{
+		m_head.m_next = __slist_sort_chain(m_head.m_next, __node_data_less<Node>(), __parallel_sort_engine(pool));
 	}
+#endif
 };
 
 template <class Tp, class Alloc>
@@ -498,4 +718,12 @@ inline void swap(slist<Tp,Alloc>& x, slist<Tp,Alloc>& y)
 	x.swap(y);
 }
 
+// nodes only point forward, never back at the embedded head, but the head
+// holds a T of its own
+template <class T, class Alloc>
+struct is_trivially_relocatable<slist<T, Alloc> >
+{
+	typedef typename is_trivially_relocatable<T>::type type;
+};
+
 __NS_END
\ No newline at end of file
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <stddef.h>
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+
+__NS_BEGIN
+
+// vector with room for N elements inside the object itself. Up to N
+// elements nothing is allocated; beyond that the elements move to a block
+// from Alloc and stay there when the vector shrinks again. The inline
+// buffer has malloc alignment, so T must not be over-aligned. N must be
+// at least 1.
+template <class T, size_t N, class Alloc = type_allocator<T> >
+class small_vector
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef Alloc allocator_type;
+
+private:
+	union __inline_buffer
+	{
+		char m_bytes[N * sizeof(T)];
+		double m_align_double;
+		long double m_align_long_double;
+		void* m_align_pointer;
+	};
+
+	T* m_start;
+	T* m_finish;
+	T* m_end_of_storage;
+	Alloc m_alloc;
+	__inline_buffer m_buffer;
+
+	T* __inline_start() { return (T*)m_buffer.m_bytes; }
+	const T* __inline_start() const { return (const T*)m_buffer.m_bytes; }
+
+	void __reset_inline()
+	{
+		m_start = m_finish = __inline_start();
+		m_end_of_storage = m_start + N;
+	}
+
+	// destroys the elements and gives back the heap block, if any
+	void __release()
+	{
+		range_destruct(m_start, m_finish);
+		if (!is_inline())
+			m_alloc.deallocate(m_start, capacity());
+	}
+
+	// moves the elements to a heap block of 'new_cap' elements
+	void __grow(size_type new_cap)
+	{
+		T* new_start = m_alloc.allocate(new_cap);
+		T* new_finish = range_move_construct(m_start, m_finish, new_start);
+		__release();
+		m_start = new_start;
+		m_finish = new_finish;
+		m_end_of_storage = new_start + new_cap;
+	}
+
+	void __grow_for(size_type n)
+	{
+		if (size_type(m_end_of_storage - m_finish) < n)
+			__grow(size() + MySTL::max(size(), n));
+	}
+
+	// 'x' is a local copy, it cannot move away while the storage grows
+	void __insert_value(size_type index, T& x)
+	{
+		__grow_for(1);
+		iterator pos = m_start + index;
+		if (pos == m_finish)
+			construct(m_finish, MySTL::move(x));
+		else
+		{
+			construct(m_finish, MySTL::move(*(m_finish - 1)));
+			MySTL::move_backward(pos, m_finish - 1, m_finish);
+			*pos = MySTL::move(x);
+		}
+		++m_finish;
+	}
+
+	void __fill_insert(iterator pos, size_type n, const T& x)
+	{
+		if (n == 0)
+			return;
+		T x_copy = x;
+		size_type index = pos - m_start;
+		__grow_for(n);
+		pos = m_start + index;
+		size_type elems_after = m_finish - pos;
+		if (elems_after >= n)
+		{
+			range_move_construct(m_finish - n, m_finish, m_finish);
+			MySTL::move_backward(pos, m_finish - n, m_finish);
+			MySTL::fill_n(pos, n, x_copy);
+		}
+		else
+		{
+			iterator new_finish = fill_construct_n(m_finish, n - elems_after, x_copy);
+			range_move_construct(pos, m_finish, new_finish);
+			MySTL::fill_n(pos, elems_after, x_copy);
+		}
+		m_finish += n;
+	}
+
+	template <class InputIterator>
+	void __range_insert(iterator pos, InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		size_type index = pos - m_start;
+		for ( ; first != last; ++first, ++index)
+			insert(m_start + index, *first);
+	}
+	template <class ForwardIterator>
+	void __range_insert(iterator pos, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		if (first == last)
+			return;
+		size_type n = MySTL::distance(first, last);
+		size_type index = pos - m_start;
+		__grow_for(n);
+		pos = m_start + index;
+		size_type elems_after = m_finish - pos;
+		if (elems_after >= n)
+		{
+			range_move_construct(m_finish - n, m_finish, m_finish);
+			MySTL::move_backward(pos, m_finish - n, m_finish);
+			MySTL::copy(first, last, pos);
+		}
+		else
+		{
+			ForwardIterator mid = first;
+			MySTL::advance(mid, elems_after);
+			iterator new_finish = range_construct(mid, last, m_finish);
+			range_move_construct(pos, m_finish, new_finish);
+			MySTL::copy(first, mid, pos);
+		}
+		m_finish += n;
+	}
+	template <class Integer>
+	void __insert_aux(iterator pos, Integer n, Integer x, true_type)
+	{
+		__fill_insert(pos, n, x);
+	}
+	template <class InputIterator>
+	void __insert_aux(iterator pos, InputIterator first, InputIterator last, false_type)
+	{
+		__range_insert(pos, first, last, iterator_category(first));
+	}
+
+public:
+	small_vector() { __reset_inline(); }
+	explicit small_vector(const Alloc& a) : m_alloc(a) { __reset_inline(); }
+	small_vector(size_type n, const T& x, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__reset_inline();
+		__fill_insert(end(), n, x);
+	}
+	explicit small_vector(size_type n)
+	{
+		__reset_inline();
+		__fill_insert(end(), n, T());
+	}
+	template <class InputIterator>
+	small_vector(InputIterator first, InputIterator last, const Alloc& a = Alloc())
+		: m_alloc(a)
+	{
+		__reset_inline();
+		insert(end(), first, last);
+	}
+	small_vector(const small_vector<T, N, Alloc>& other)
+		: m_alloc(other.m_alloc)
+	{
+		__reset_inline();
+		insert(end(), other.begin(), other.end());
+	}
+#if defined(__MYSTL_CXX11)
+	small_vector(small_vector<T, N, Alloc>&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+		: m_alloc(other.m_alloc)
+	{
+		__reset_inline();
+		__steal(other);
+	}
+#endif
+
+	~small_vector() { __release(); }
+
+	iterator begin() { return m_start; }
+	const_iterator begin() const { return m_start; }
+	iterator end() { return m_finish; }
+	const_iterator end() const { return m_finish; }
+	size_type size() const { return m_finish - m_start; }
+	size_type capacity() const { return m_end_of_storage - m_start; }
+	bool empty() const { return m_start == m_finish; }
+	bool is_inline() const { return m_start == __inline_start(); }
+	reference front() { return *m_start; }
+	const_reference front() const { return *m_start; }
+	reference back() { return *(m_finish - 1); }
+	const_reference back() const { return *(m_finish - 1); }
+	allocator_type get_allocator() const { return m_alloc; }
+
+	T& operator[](size_type index) { return m_start[index]; }
+	const T& operator[](size_type index) const { return m_start[index]; }
+
+	void insert(iterator pos, const T& x)
+	{
+		T x_copy = x;
+		__insert_value(pos - m_start, x_copy);
+	}
+	void push_back(const T& x)
+	{
+		if (m_finish != m_end_of_storage)
+		{
+			construct(m_finish, x);
+			++m_finish;
+		}
+		else
+			insert(end(), x);
+	}
+	void push_front(const T& x) { insert(begin(), x); }
+	void insert(iterator pos, size_type n, const T& x) { __fill_insert(pos, n, x); }
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last)
+	{
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__insert_aux(pos, first, last, is_int());
+	}
+
+#if defined(__MYSTL_CXX11)
+	void insert(iterator pos, T&& x)
+	{
+		T x_copy(MySTL::move(x));
+		__insert_value(pos - m_start, x_copy);
+	}
+	void push_back(T&& x) { emplace_back(MySTL::move(x)); }
+	template <class... Args>
+	iterator emplace(iterator pos, Args&&... args)
+	{
+		size_type index = pos - m_start;
+		T x(MySTL::forward<Args>(args)...);
+		__insert_value(index, x);
+		return m_start + index;
+	}
+	template <class... Args>
+	void emplace_back(Args&&... args)
+	{
+		if (m_finish != m_end_of_storage)
+		{
+			construct(m_finish, MySTL::forward<Args>(args)...);
+			++m_finish;
+		}
+		else
+			emplace(end(), MySTL::forward<Args>(args)...);
+	}
+#endif
+
+	iterator erase(iterator pos)
+	{
+		MySTL::move(pos + 1, m_finish, pos);
+		--m_finish;
+		destruct(m_finish);
+		return pos;
+	}
+	iterator erase(iterator first, iterator last)
+	{
+		iterator new_finish = MySTL::move(last, m_finish, first);
+		range_destruct(new_finish, m_finish);
+		m_finish = new_finish;
+		return first;
+	}
+	void pop_back()
+	{
+		--m_finish;
+		destruct(m_finish);
+	}
+	void clear() { erase(m_start, m_finish); }
+
+	void resize(size_type new_sz, const T& x)
+	{
+		if (new_sz > size())
+			__fill_insert(m_finish, new_sz - size(), x);
+		else
+			erase(m_start + new_sz, m_finish);
+	}
+	void resize(size_type new_sz) { resize(new_sz, T()); }
+	void reserve(size_type n)
+	{
+		if (n > capacity())
+			__grow(n);
+	}
+
+	void assign(size_type n, const T& x)
+	{
+		clear();
+		__fill_insert(m_finish, n, x);
+	}
+	template <class InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		insert(m_finish, first, last);
+	}
+	small_vector<T, N, Alloc>& operator=(const small_vector<T, N, Alloc>& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	small_vector<T, N, Alloc>& operator=(small_vector<T, N, Alloc>&& other)
+		noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &other)
+		{
+			__release();
+			__reset_inline();
+			m_alloc = other.m_alloc;
+			__steal(other);
+		}
+		return *this;
+	}
+#endif
+
+	// heap blocks are exchanged, inline elements are swapped one by one
+	void swap(small_vector<T, N, Alloc>& other)
+	{
+		if (this == &other)
+			return;
+		if (!is_inline() && !other.is_inline())
+		{
+			MySTL::swap(m_start, other.m_start);
+			MySTL::swap(m_finish, other.m_finish);
+			MySTL::swap(m_end_of_storage, other.m_end_of_storage);
+			MySTL::swap(m_alloc, other.m_alloc);
+			return;
+		}
+		small_vector<T, N, Alloc>& longer = size() >= other.size() ? *this : other;
+		small_vector<T, N, Alloc>& shorter = size() >= other.size() ? other : *this;
+		size_type common = shorter.size();
+		shorter.reserve(longer.size());
+		for (size_type i = 0; i < common; ++i)
+			MySTL::swap(m_start[i], other.m_start[i]);
+		for (iterator i = longer.m_start + common; i != longer.m_finish; ++i)
+			shorter.push_back(MySTL::move(*i));
+		longer.erase(longer.m_start + common, longer.m_finish);
+	}
+
+private:
+#if defined(__MYSTL_CXX11)
+	// takes the heap block of 'other' or moves its inline elements, this
+	// vector is empty and inline
+	void __steal(small_vector<T, N, Alloc>& other)
+	{
+		if (other.is_inline())
+		{
+			for (iterator i = other.m_start; i != other.m_finish; ++i)
+				emplace_back(MySTL::move(*i));
+			other.clear();
+		}
+		else
+		{
+			m_start = other.m_start;
+			m_finish = other.m_finish;
+			m_end_of_storage = other.m_end_of_storage;
+			other.__reset_inline();
+		}
+	}
+#endif
+};
+
+__NS_END
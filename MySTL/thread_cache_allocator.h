@@ -0,0 +1,319 @@
+#pragma once
+
+// needs C++11: thread_local and std::mutex
+#include <mutex>
+#include "config.h"
+#include "allocator.h"
+
+__NS_BEGIN
+
+// Thread caching front end. Small requests are rounded up to a multiple of
+// __ALIGN and served from a per-thread magazine (a free list with a count)
+// without taking any lock. An empty magazine is refilled with __BATCH
+// objects from the central pool, a magazine that grows beyond __MAX_CACHED
+// hands __BATCH objects back. The central pool keeps one locked free list
+// per size class and carves new objects from large chunks.
+//
+// Objects are not owned by the thread that allocated them: a block freed on
+// another thread goes into that thread's magazine and flows back to the
+// central pool once the magazine overflows, so producer/consumer patterns
+// do not leak. A thread's magazines are returned to the central pool when
+// it exits. Chunks are never given back.
+template <int inst>
+class __thread_cache_alloc_template
+{
+private:
+	enum { __ALIGN = 8 };
+	enum { __MAX_BYTES = 256 };
+	enum { __NCLASSES = __MAX_BYTES / __ALIGN };
+	enum { __BATCH = 32 };
+	enum { __MAX_CACHED = 2 * __BATCH };
+	enum { __CHUNK_BYTES = 64 * 1024 };
+
+	struct __obj
+	{
+		__obj* m_next;
+	};
+
+	struct __central_list
+	{
+		std::mutex m_lock;
+		__obj* m_head;
+
+		__central_list() : m_head(0) {}
+	};
+
+	struct __central_pool
+	{
+		__central_list m_lists[__NCLASSES];
+		std::mutex m_chunk_lock;
+		char* m_start_free;
+		char* m_end_free;
+
+		__central_pool() : m_start_free(0), m_end_free(0) {}
+	};
+
+	struct __magazine
+	{
+		__obj* m_head;
+		size_t m_count;
+	};
+
+	struct __thread_cache
+	{
+		__magazine m_magazines[__NCLASSES];
+		bool m_destroyed;
+
+		__thread_cache() : m_destroyed(false)
+		{
+			for (int i = 0; i < __NCLASSES; ++i)
+			{
+				m_magazines[i].m_head = 0;
+				m_magazines[i].m_count = 0;
+			}
+		}
+		~__thread_cache()
+		{
+			for (int i = 0; i < __NCLASSES; ++i)
+				__flush(i, m_magazines[i], m_magazines[i].m_count);
+			m_destroyed = true;
+		}
+	};
+
+	static size_t __class_index(size_t bytes)
+	{
+		return (bytes + __ALIGN - 1) / __ALIGN - 1;
+	}
+
+	static size_t __class_size(size_t index)
+	{
+		return (index + 1) * __ALIGN;
+	}
+
+	// the central pool is never destroyed, thread caches may outlive
+	// static destruction
+	static __central_pool& __central()
+	{
+		static __central_pool* pool = new __central_pool;
+		return *pool;
+	}
+
+	static __thread_cache& __cache()
+	{
+		static thread_local __thread_cache cache;
+		return cache;
+	}
+
+	// links the chain [first, last] into the central list of 'index'
+	static void __central_push(size_t index, __obj* first, __obj* last)
+	{
+		__central_list& list = __central().m_lists[index];
+		std::lock_guard<std::mutex> guard(list.m_lock);
+		last->m_next = list.m_head;
+		list.m_head = first;
+	}
+
+	// moves 'n' objects from the magazine to the central pool
+	static void __flush(size_t index, __magazine& m, size_t n)
+	{
+		if (n == 0)
+			return;
+		__obj* first = m.m_head;
+		__obj* last = first;
+		for (size_t i = 1; i < n; ++i)
+			last = last->m_next;
+		m.m_head = last->m_next;
+		m.m_count -= n;
+		__central_push(index, first, last);
+	}
+
+	// fills an empty magazine with up to __BATCH objects, taken from the
+	// central list first and carved from a chunk otherwise
+	static void __refill(size_t index, __magazine& m)
+	{
+		__central_list& list = __central().m_lists[index];
+		{
+			std::lock_guard<std::mutex> guard(list.m_lock);
+			if (list.m_head)
+			{
+				__obj* first = list.m_head;
+				__obj* last = first;
+				size_t n = 1;
+				for ( ; n < (size_t)__BATCH && last->m_next; ++n)
+					last = last->m_next;
+				list.m_head = last->m_next;
+				last->m_next = 0;
+				m.m_head = first;
+				m.m_count = n;
+				return;
+			}
+		}
+
+		const size_t size = __class_size(index);
+		size_t n = __BATCH;
+		char* chunk = __chunk_alloc(size, n);
+		__obj* head = 0;
+		for (size_t i = n; i > 0; --i)
+		{
+			__obj* q = (__obj*)(chunk + (i - 1) * size);
+			q->m_next = head;
+			head = q;
+		}
+		m.m_head = head;
+		m.m_count = n;
+	}
+
+	// one object for a thread whose cache is already destroyed
+	static __obj* __central_pop(size_t index)
+	{
+		__central_list& list = __central().m_lists[index];
+		{
+			std::lock_guard<std::mutex> guard(list.m_lock);
+			if (list.m_head)
+			{
+				__obj* q = list.m_head;
+				list.m_head = q->m_next;
+				return q;
+			}
+		}
+		size_t n = 1;
+		return (__obj*)__chunk_alloc(__class_size(index), n);
+	}
+
+	// hands 'bytes' at 'p' to the central lists; a piece that would be a
+	// misaligned object of its class gives its first __ALIGN bytes to the
+	// smallest class
+	static void __central_push_piece(char* p, size_t bytes)
+	{
+		if (bytes % __MALLOC_ALIGN == 0 && (size_t)p % __MALLOC_ALIGN != 0)
+		{
+			__central_push(0, (__obj*)p, (__obj*)p);
+			p += __ALIGN;
+			bytes -= __ALIGN;
+		}
+		if (bytes != 0)
+			__central_push(__class_index(bytes), (__obj*)p, (__obj*)p);
+	}
+
+	// carves up to 'n' objects of 'size' bytes, 'n' is lowered when the
+	// current chunk only has room for fewer. Objects of a size that is a
+	// multiple of __MALLOC_ALIGN start on that alignment.
+	static char* __chunk_alloc(size_t size, size_t& n)
+	{
+		__central_pool& pool = __central();
+		std::lock_guard<std::mutex> guard(pool.m_chunk_lock);
+		if (size % __MALLOC_ALIGN == 0 && (size_t)pool.m_start_free % __MALLOC_ALIGN != 0
+			&& pool.m_end_free - pool.m_start_free >= (ptrdiff_t)__ALIGN)
+		{
+			__central_push_piece(pool.m_start_free, __ALIGN);
+			pool.m_start_free += __ALIGN;
+		}
+		size_t bytes_left = pool.m_end_free - pool.m_start_free;
+		if (bytes_left < size)
+		{
+			if (bytes_left > 0)
+				__central_push_piece(pool.m_start_free, bytes_left);
+			pool.m_start_free = (char*)allocator::allocate(__CHUNK_BYTES);
+			pool.m_end_free = pool.m_start_free + __CHUNK_BYTES;
+			bytes_left = __CHUNK_BYTES;
+		}
+		if (n * size > bytes_left)
+			n = bytes_left / size;
+		char* result = pool.m_start_free;
+		pool.m_start_free += n * size;
+		return result;
+	}
+
+public:
+	static void* allocate(size_t n)
+	{
+		if (n == 0)
+			return 0;
+		if (n > (size_t)__MAX_BYTES)
+			return allocator::allocate(n);
+
+		const size_t index = __class_index(n);
+		__thread_cache& cache = __cache();
+		if (cache.m_destroyed)
+		{
+			// allocated by another thread_local destructor after the cache is
+			// gone, a refilled magazine would never be flushed
+			return __central_pop(index);
+		}
+		__magazine& m = cache.m_magazines[index];
+		if (m.m_head == 0)
+			__refill(index, m);
+		__obj* result = m.m_head;
+		m.m_head = result->m_next;
+		--m.m_count;
+		return result;
+	}
+
+	// the magazines already move objects in batches
+	static void* allocate_chain(size_t n, size_t count)
+	{
+		return __allocate_chain_each<__thread_cache_alloc_template<inst> >(n, count);
+	}
+
+	static void deallocate(void* p, size_t n)
+	{
+		if (p == 0)
+			return;
+		if (n > (size_t)__MAX_BYTES)
+		{
+			allocator::deallocate(p, n);
+			return;
+		}
+
+		const size_t index = __class_index(n);
+		__obj* q = (__obj*)p;
+		__thread_cache& cache = __cache();
+		if (cache.m_destroyed)
+		{
+			// freed by another thread_local destructor after the cache is gone
+			__central_push(index, q, q);
+			return;
+		}
+		__magazine& m = cache.m_magazines[index];
+		q->m_next = m.m_head;
+		m.m_head = q;
+		if (++m.m_count > (size_t)__MAX_CACHED)
+			__flush(index, m, __BATCH);
+	}
+
+	// over-aligned objects do not come from the magazines
+	static void* allocate(size_t n, size_t align) { return allocator::allocate(n, align); }
+	static void deallocate(void* p, size_t n, size_t align) { allocator::deallocate(p, n, align); }
+	static void* reallocate(void* p, size_t old_n, size_t new_n, size_t align)
+	{
+		return allocator::reallocate(p, old_n, new_n, align);
+	}
+
+	static void* reallocate(void* p, size_t old_n, size_t new_n)
+	{
+		if (p && old_n > (size_t)__MAX_BYTES && new_n > (size_t)__MAX_BYTES)
+			return allocator::reallocate(p, old_n, new_n);
+		if (try_expand_in_place(p, old_n, new_n))
+			return p;
+		void* result = allocate(new_n);
+		if (p)
+		{
+			memcpy(result, p, old_n < new_n ? old_n : new_n);
+			deallocate(p, old_n);
+		}
+		return result;
+	}
+
+	static bool try_expand_in_place(void* p, size_t old_n, size_t new_n)
+	{
+		if (p == 0 || new_n == 0)
+			return false;
+		if (old_n > (size_t)__MAX_BYTES)
+			return new_n > (size_t)__MAX_BYTES && allocator::try_expand_in_place(p, old_n, new_n);
+		return new_n <= (size_t)__MAX_BYTES && __class_index(new_n) == __class_index(old_n);
+	}
+};
+
+typedef __thread_cache_alloc_template<0> thread_cache_allocator;
+
+__NS_END
@@ -0,0 +1,456 @@
+#pragma once
+
+// needs C++11: std::thread, std::mutex and std::atomic
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <new>
+#include "config.h"
+#include "algo_base.h"
+#include "allocator.h"
+#include "thread_cache_allocator.h"
+#include "vector.h"
+#include "circular_buffer.h"
+#include "node_sort.h"
+#include "work_stealing_deque.h"
+
+__NS_BEGIN
+
+class thread_pool;
+class task_group;
+
+// a spawned function object, it frees itself after it has run. Tasks are
+// allocated on one thread and freed on another, thread_cache_allocator
+// keeps that lock free.
+struct __task
+{
+	std::atomic<size_t>* m_pending;
+
+	explicit __task(std::atomic<size_t>* pending) : m_pending(pending) {}
+	virtual ~__task() {}
+	// runs the function, frees the task and then counts it done
+	virtual void __execute() = 0;
+};
+
+template <class F>
+struct __task_impl : public __task
+{
+	typedef type_allocator<__task_impl<F>, thread_cache_allocator> TaskAllocator;
+
+	F m_f;
+
+	__task_impl(const F& f, std::atomic<size_t>* pending) : __task(pending), m_f(f) {}
+
+	static __task* __create(const F& f, std::atomic<size_t>* pending)
+	{
+		return new (TaskAllocator::allocate()) __task_impl<F>(f, pending);
+	}
+
+	virtual void __execute()
+	{
+		m_f();
+		std::atomic<size_t>* pending = m_pending;
+		this->~__task_impl();
+		TaskAllocator::deallocate(this);
+		pending->fetch_sub(1, std::memory_order_release);
+	}
+};
+
+// Fixed pool of worker threads with a work stealing deque each. A task
+// spawned on a worker goes to the bottom of its own deque and the worker
+// keeps taking from there, newest first, while idle workers steal the
+// oldest tasks from the top of a random victim: for divide and conquer
+// code the thieves take the large pieces. Tasks submitted from other
+// threads wait in a shared locked queue. A thread that waits for tasks
+// runs tasks meanwhile, so nested waits do not block a worker. Workers
+// with nothing to do sleep on a condition variable. Tasks must not throw.
+class thread_pool
+{
+	friend class task_group;
+
+private:
+	struct __worker
+	{
+		thread_pool* m_pool;
+		work_stealing_deque<__task*> m_deque;
+		unsigned m_seed;
+		std::thread m_thread;
+
+		__worker(thread_pool* pool, unsigned seed) : m_pool(pool), m_seed(seed) {}
+	};
+
+	vector<__worker*> m_workers;
+	std::mutex m_inject_lock;
+	circular_buffer<__task*> m_inject;
+	std::atomic<size_t> m_inject_size;
+
+	std::mutex m_sleep_lock;
+	std::condition_variable m_wake;
+	std::atomic<size_t> m_epoch;
+	std::atomic<size_t> m_sleepers;
+	bool m_stop;
+
+	std::atomic<size_t> m_pending;
+
+	thread_pool(const thread_pool&);
+	thread_pool& operator=(const thread_pool&);
+
+	static __worker*& __current()
+	{
+		static thread_local __worker* current = 0;
+		return current;
+	}
+
+	__worker* __local_worker()
+	{
+		__worker* w = __current();
+		return w && w->m_pool == this ? w : 0;
+	}
+
+	void __submit(__task* t)
+	{
+		__worker* w = __local_worker();
+		if (w)
+			w->m_deque.push(t);
+		else
+		{
+			std::lock_guard<std::mutex> guard(m_inject_lock);
+			m_inject.push_back(t);
+			m_inject_size.fetch_add(1, std::memory_order_relaxed);
+		}
+		// pairs with the fence in __sleep: either this sees the sleeper
+		// or the sleeper sees the task
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleepers.load(std::memory_order_relaxed) != 0)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_sleep_lock);
+				m_epoch.fetch_add(1, std::memory_order_relaxed);
+			}
+			m_wake.notify_one();
+		}
+	}
+
+	__task* __take_injected()
+	{
+		if (m_inject_size.load(std::memory_order_relaxed) == 0)
+			return 0;
+		std::lock_guard<std::mutex> guard(m_inject_lock);
+		if (m_inject.empty())
+			return 0;
+		__task* t = m_inject.front();
+		m_inject.pop_front();
+		m_inject_size.fetch_sub(1, std::memory_order_relaxed);
+		return t;
+	}
+
+	__task* __steal(unsigned& seed)
+	{
+		size_t n = m_workers.size();
+		// xorshift picks where to start, then every victim is tried once
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		size_t start = seed % n;
+		for (size_t i = 0; i < n; ++i)
+		{
+			__task* t;
+			if (m_workers[(start + i) % n]->m_deque.steal(t))
+				return t;
+		}
+		return 0;
+	}
+
+	__task* __find_task(__worker* w, unsigned& seed)
+	{
+		__task* t;
+		if (w && w->m_deque.pop(t))
+			return t;
+		t = __take_injected();
+		if (t == 0)
+			t = __steal(seed);
+		return t;
+	}
+
+	// runs one task if there is any, from any thread
+	bool __run_one(unsigned& seed)
+	{
+		__worker* w = __local_worker();
+		__task* t = __find_task(w, w ? w->m_seed : seed);
+		if (t == 0)
+			return false;
+		t->__execute();
+		return true;
+	}
+
+	// false when the pool is stopping
+	bool __sleep(__worker* w)
+	{
+		size_t epoch = m_epoch.load(std::memory_order_relaxed);
+		m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+		// pairs with the fence in __submit; the RMW alone does not order the
+		// relaxed loads of __find_task after it
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		__task* t = __find_task(w, w->m_seed);
+		if (t)
+		{
+			m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+			t->__execute();
+			return true;
+		}
+		std::unique_lock<std::mutex> lock(m_sleep_lock);
+		while (m_epoch.load(std::memory_order_relaxed) == epoch && !m_stop)
+			m_wake.wait(lock);
+		m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+		return !m_stop;
+	}
+
+	void __work(__worker* w)
+	{
+		__current() = w;
+		for (;;)
+		{
+			__task* t = __find_task(w, w->m_seed);
+			if (t)
+				t->__execute();
+			else if (!__sleep(w))
+				break;
+		}
+		__current() = 0;
+	}
+
+	// waits for 'pending' to drop to zero and runs tasks meanwhile
+	void __wait(std::atomic<size_t>& pending)
+	{
+		unsigned seed = (unsigned)(size_t)&pending | 1;
+		while (pending.load(std::memory_order_acquire) != 0)
+		{
+			if (!__run_one(seed))
+				std::this_thread::yield();
+		}
+	}
+
+	template <class Index, class F>
+	void __parallel_for(task_group& g, Index first, Index last, Index grain, const F& f);
+
+public:
+	// 'n' workers, by default one per hardware thread
+	explicit thread_pool(size_t n = 0)
+		: m_inject_size(0), m_epoch(0), m_sleepers(0), m_stop(false), m_pending(0)
+	{
+		if (n == 0)
+			n = MySTL::max(1u, std::thread::hardware_concurrency());
+		m_workers.reserve(n);
+		for (size_t i = 0; i < n; ++i)
+			m_workers.push_back(new __worker(this, unsigned(2 * i + 1)));
+		for (size_t i = 0; i < n; ++i)
+			m_workers[i]->m_thread = std::thread(&thread_pool::__work, this, m_workers[i]);
+	}
+
+	// runs what is left, then stops the workers
+	~thread_pool()
+	{
+		wait();
+		{
+			std::lock_guard<std::mutex> guard(m_sleep_lock);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (size_t i = 0; i < m_workers.size(); ++i)
+		{
+			m_workers[i]->m_thread.join();
+			delete m_workers[i];
+		}
+	}
+
+	size_t size() const { return m_workers.size(); }
+
+	// runs f() on some worker, wait() waits for it
+	template <class F>
+	void submit(const F& f)
+	{
+		m_pending.fetch_add(1, std::memory_order_relaxed);
+		__submit(__task_impl<F>::__create(f, &m_pending));
+	}
+
+	// waits until every submitted task has run, helping to run them
+	void wait() { __wait(m_pending); }
+
+	// f(i) for every i in [first, last), split in halves down to pieces of
+	// at most 'grain' indices
+	template <class Index, class F>
+	void parallel_for(Index first, Index last, Index grain, const F& f);
+};
+
+// Fork/join scope on a pool: spawn() forks a task, sync() joins all the
+// tasks spawned through this group, running pool tasks while it waits.
+// The destructor syncs, so tasks may refer to locals of the scope.
+class task_group
+{
+private:
+	thread_pool& m_pool;
+	std::atomic<size_t> m_pending;
+
+	task_group(const task_group&);
+	task_group& operator=(const task_group&);
+
+public:
+	explicit task_group(thread_pool& pool) : m_pool(pool), m_pending(0) {}
+	~task_group() { sync(); }
+
+	template <class F>
+	void spawn(const F& f)
+	{
+		m_pending.fetch_add(1, std::memory_order_relaxed);
+		m_pool.__submit(__task_impl<F>::__create(f, &m_pending));
+	}
+
+	void sync() { m_pool.__wait(m_pending); }
+
+	thread_pool& pool() { return m_pool; }
+};
+
+// the right half is spawned, the left one is split further on this thread
+template <class Index, class F>
+void thread_pool::__parallel_for(task_group& g, Index first, Index last, Index grain, const F& f)
+{
+	while (last - first > grain)
+	{
+		Index mid = first + (last - first) / 2;
+		Index end = last;
+		g.spawn([this, &g, mid, end, grain, &f] { __parallel_for(g, mid, end, grain, f); });
+		last = mid;
+	}
+	for ( ; first != last; ++first)
+		f(first);
+}
+
+template <class Index, class F>
+void thread_pool::parallel_for(Index first, Index last, Index grain, const F& f)
+{
+	if (grain < 1)
+		grain = 1;
+	task_group g(*this);
+	__parallel_for(g, first, last, grain, f);
+	g.sync();
+}
+
+// Parallel stable sort of the arrays of the list sorts: pieces of at least
+// __parallel_sort_grain elements are sorted by the serial code, then pairs
+// of sorted runs are merged into the other array, each merge split in
+// parallel pieces as well.
+enum { __parallel_sort_grain = 8192 };
+
+// stable merge of two sorted ranges into 'result': the longer range is cut
+// in the middle and the other one where that element belongs, the right
+// halves merge in a task
+template <class T, class Compare>
+void __parallel_merge(thread_pool& pool, T* first1, T* last1, T* first2, T* last2, T* result, Compare comp)
+{
+	task_group g(pool);
+	while ((last1 - first1) + (last2 - first2) > (ptrdiff_t)__parallel_sort_grain)
+	{
+		T* mid1;
+		T* mid2;
+		if (last1 - first1 >= last2 - first2)
+		{
+			// the elements of the second range before the first not less than *mid1
+			mid1 = first1 + (last1 - first1) / 2;
+			mid2 = first2;
+			for (ptrdiff_t len = last2 - first2; len > 0; )
+			{
+				ptrdiff_t half = len / 2;
+				if (comp(mid2[half], *mid1))
+				{
+					mid2 += half + 1;
+					len -= half + 1;
+				}
+				else
+					len = half;
+			}
+		}
+		else
+		{
+			// the elements of the first range up to the last not greater than *mid2
+			mid2 = first2 + (last2 - first2) / 2;
+			mid1 = first1;
+			for (ptrdiff_t len = last1 - first1; len > 0; )
+			{
+				ptrdiff_t half = len / 2;
+				if (!comp(*mid2, mid1[half]))
+				{
+					mid1 += half + 1;
+					len -= half + 1;
+				}
+				else
+					len = half;
+			}
+		}
+		T* right = result + (mid1 - first1) + (mid2 - first2);
+		g.spawn([&pool, mid1, last1, mid2, last2, right, comp] { __parallel_merge(pool, mid1, last1, mid2, last2, right, comp); });
+		last1 = mid1;
+		last2 = mid2;
+	}
+	__merge_arrays(first1, last1, first2, last2, result, comp);
+	g.sync();
+}
+
+// sorts a[0, n) into 'a', or into 'buf' when 'to_buf': the halves are
+// sorted into the other array and merged from there
+template <class T, class Compare, class Leaf>
+void __parallel_sort_array(thread_pool& pool, T* a, T* buf, size_t n, bool to_buf, size_t grain, Compare comp, const Leaf& leaf)
+{
+	if (n <= grain)
+	{
+		leaf(a, buf, n);
+		if (to_buf)
+			memcpy(buf, a, n * sizeof(T));
+		return;
+	}
+	size_t half = n / 2;
+	{
+		task_group g(pool);
+		g.spawn([&pool, a, buf, half, to_buf, grain, comp, &leaf] { __parallel_sort_array(pool, a, buf, half, !to_buf, grain, comp, leaf); });
+		__parallel_sort_array(pool, a + half, buf + half, n - half, !to_buf, grain, comp, leaf);
+	}
+	T* from = to_buf ? a : buf;
+	T* to = to_buf ? buf : a;
+	__parallel_merge(pool, from, from + half, from + half, from + n, to, comp);
+}
+
+// pieces for about four per worker, none below the grain; 0 when the sort
+// should stay on this thread
+inline size_t __parallel_sort_piece(thread_pool& pool, size_t n)
+{
+	if (pool.size() < 2 || n < 2 * (size_t)__parallel_sort_grain)
+		return 0;
+	return MySTL::max(n / (4 * pool.size()), (size_t)__parallel_sort_grain);
+}
+
+template <class T, class Compare>
+void __parallel_stable_sort_array(thread_pool& pool, T* a, T* buf, size_t n, Compare comp)
+{
+	size_t grain = __parallel_sort_piece(pool, n);
+	if (grain == 0)
+		__stable_sort_array(a, buf, n, comp);
+	else
+		__parallel_sort_array(pool, a, buf, n, false, grain, comp,
+			[comp](T* a, T* buf, size_t n) { __stable_sort_array(a, buf, n, comp); });
+}
+
+// the pieces are radix sorted, the merges compare the keys
+template <class Node>
+void __parallel_radix_sort_items(thread_pool& pool, __radix_item<Node>* a, __radix_item<Node>* buf, size_t n, size_t key_bytes)
+{
+	typedef __radix_item<Node> Item;
+	size_t grain = __parallel_sort_piece(pool, n);
+	if (grain == 0)
+		__radix_sort_items(a, buf, n, key_bytes);
+	else
+		__parallel_sort_array(pool, a, buf, n, false, grain, __radix_item_less<Node>(),
+			[key_bytes](Item* a, Item* buf, size_t n) { __radix_sort_items(a, buf, n, key_bytes); });
+}
+
+__NS_END
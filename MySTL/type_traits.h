@@ -2,11 +2,61 @@
 
 #include "config.h"
 
+#if defined(__MYSTL_CXX11)
+#include <type_traits>
+#endif
+
+// Traits the compiler can tell for any complete type: <type_traits> in
+// C++11, otherwise the intrinsics of MSVC (VS2005 and later) and GCC (4.3
+// and later). With neither, only the specializations below are trivial.
+#if defined(__MYSTL_CXX11)
+#define __MYSTL_HAS_TRIVIAL_CONSTRUCTOR(T) std::is_trivially_default_constructible<T>::value
+#define __MYSTL_HAS_TRIVIAL_COPY(T) std::is_trivially_copy_constructible<T>::value
+#define __MYSTL_HAS_TRIVIAL_ASSIGN(T) std::is_trivially_copy_assignable<T>::value
+#define __MYSTL_HAS_TRIVIAL_DESTRUCTOR(T) std::is_trivially_destructible<T>::value
+#elif (defined(_MSC_VER) && _MSC_VER >= 1400) || \
+	(defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3)))
+#define __MYSTL_HAS_TRIVIAL_CONSTRUCTOR(T) __has_trivial_constructor(T)
+#define __MYSTL_HAS_TRIVIAL_COPY(T) __has_trivial_copy(T)
+#define __MYSTL_HAS_TRIVIAL_ASSIGN(T) __has_trivial_assign(T)
+#define __MYSTL_HAS_TRIVIAL_DESTRUCTOR(T) __has_trivial_destructor(T)
+#endif
+
 __NS_BEGIN
 
 struct true_type {};
 struct false_type {};
 
+template <bool B>
+struct __bool_type
+{
+	typedef false_type type;
+};
+
+template <>
+struct __bool_type<true>
+{
+	typedef true_type type;
+};
+
+inline bool __is_true(true_type) { return true; }
+inline bool __is_true(false_type) { return false; }
+
+#if defined(__MYSTL_HAS_TRIVIAL_COPY)
+// is_POD_type only promises what the library relies on: elements can be
+// copied, assigned, relocated and destroyed as raw bytes. A user-declared
+// default constructor does not matter.
+template <typename T>
+struct type_traits
+{
+	typedef typename __bool_type<__MYSTL_HAS_TRIVIAL_CONSTRUCTOR(T)>::type has_trivial_default_constructor;
+	typedef typename __bool_type<__MYSTL_HAS_TRIVIAL_COPY(T)>::type has_trivial_copy_constructor;
+	typedef typename __bool_type<__MYSTL_HAS_TRIVIAL_ASSIGN(T)>::type has_trivial_assignment_operator;
+	typedef typename __bool_type<__MYSTL_HAS_TRIVIAL_DESTRUCTOR(T)>::type has_trivial_destructor;
+	typedef typename __bool_type<__MYSTL_HAS_TRIVIAL_COPY(T) && __MYSTL_HAS_TRIVIAL_ASSIGN(T) && 
+		__MYSTL_HAS_TRIVIAL_DESTRUCTOR(T)>::type is_POD_type;
+};
+#else
 template <typename T>
 struct type_traits
 {
@@ -16,6 +66,7 @@ struct type_traits
 	typedef false_type has_trivial_destructor;
 	typedef false_type is_POD_type; // POD: Plain Old Data
 };
+#endif
 
 template <class T>
 struct type_traits<T*> 
@@ -79,6 +130,19 @@ DEFINE_TYPE_TRAITS_FOR(double);
 DEFINE_TYPE_TRAITS_FOR(long double);
 DEFINE_TYPE_TRAITS_FOR(__int64);
 
+// Opt-in: an object of type T can be moved to another address with memcpy,
+// after which the source counts as destroyed. True for POD types; other
+// types qualify when no pointer refers back into the object itself, e.g.
+// containers that only own heap blocks.
+template <class T>
+struct is_trivially_relocatable
+{
+	typedef typename type_traits<T>::is_POD_type type;
+};
+
+#define DEFINE_TRIVIALLY_RELOCATABLE(T) \
+	template <> struct is_trivially_relocatable<T> { typedef true_type type; }
+
 // integer traits
 template <class T> struct is_integer 
 {
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <stddef.h>
+#include "algo_base.h"
+#include "allocator.h"
+#include "initialize.h"
+#include "type_traits.h"
+
+__NS_BEGIN
+
+// elements per node, about 256 bytes of them and never fewer than 4
+template <size_t Size>
+struct __unrolled_node_capacity
+{
+	enum { value = Size * 4 < 256 ? 256 / Size : 4 };
+};
+
+struct __unrolled_node_base
+{
+	__unrolled_node_base* m_next;
+	__unrolled_node_base* m_prev;
+};
+
+template <class T, size_t N>
+struct __unrolled_node : public __unrolled_node_base
+{
+	size_t m_count;
+	union
+	{
+		char m_bytes[N * sizeof(T)];
+		double m_align_double;
+		long double m_align_long_double;
+		void* m_align_pointer;
+	} m_storage;
+
+	T* __data() { return (T*)m_storage.m_bytes; }
+};
+
+// the position of an element is its node and its index there; end() is
+// the sentinel with index 0
+template <class T, size_t N, class Ref, class Ptr>
+struct __unrolled_list_iterator
+{
+	typedef bidirectional_iterator_tag category;
+	typedef T value_type;
+	typedef Ptr pointer;
+	typedef Ref reference;
+	typedef ptrdiff_t difference_type;
+	typedef __unrolled_list_iterator<T, N, Ref, Ptr> Self;
+	typedef __unrolled_list_iterator<T, N, T&, T*> iterator;
+	typedef __unrolled_node<T, N> Node;
+
+	__unrolled_node_base* m_node;
+	size_t m_index;
+
+	__unrolled_list_iterator() : m_node(0), m_index(0) {}
+	__unrolled_list_iterator(__unrolled_node_base* node, size_t index) : m_node(node), m_index(index) {}
+	__unrolled_list_iterator(const iterator& x) : m_node(x.m_node), m_index(x.m_index) {}
+
+	reference operator*() const { return ((Node*)m_node)->__data()[m_index]; }
+	pointer operator->() const { return &**this; }
+	bool operator==(const Self& x) const { return m_node == x.m_node && m_index == x.m_index; }
+	bool operator!=(const Self& x) const { return !(*this == x); }
+
+	Self& operator++()
+	{
+		if (++m_index == ((Node*)m_node)->m_count)
+		{
+			m_node = m_node->m_next;
+			m_index = 0;
+		}
+		return *this;
+	}
+	Self operator++(int) { Self tmp = *this; ++*this; return tmp; }
+	Self& operator--()
+	{
+		if (m_index == 0)
+		{
+			m_node = m_node->m_prev;
+			m_index = ((Node*)m_node)->m_count;
+		}
+		--m_index;
+		return *this;
+	}
+	Self operator--(int) { Self tmp = *this; --*this; return tmp; }
+};
+
+// Doubly linked list of nodes that hold up to N elements each, so a scan
+// touches one node per N elements instead of one per element. Every node
+// but the last is at least half full: a full node splits in two halves on
+// insert, and a node that drops below half takes an element from its
+// successor or merges with it on erase. Insert and erase at an iterator
+// move at most N elements and invalidate the iterators into the nodes
+// they touch. size() is O(1).
+template <class T, size_t N = __unrolled_node_capacity<sizeof(T)>::value, class Alloc = allocator>
+class unrolled_list
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef __unrolled_list_iterator<T, N, T&, T*> iterator;
+	typedef __unrolled_list_iterator<T, N, const T&, const T*> const_iterator;
+
+private:
+	typedef __unrolled_node<T, N> Node;
+	typedef type_allocator<Node, Alloc> NodeAllocator;
+
+	enum { __half = N / 2 > 0 ? N / 2 : 1 };
+
+	__unrolled_node_base m_root;
+	size_type m_size;
+
+	__unrolled_node_base* __root() const { return const_cast<__unrolled_node_base*>(&m_root); }
+	static Node* __node(__unrolled_node_base* p) { return (Node*)p; }
+
+	// a new empty node after 'prev'
+	Node* __create_node(__unrolled_node_base* prev)
+	{
+		Node* p = NodeAllocator::allocate();
+		p->m_count = 0;
+		p->m_prev = prev;
+		p->m_next = prev->m_next;
+		prev->m_next->m_prev = p;
+		prev->m_next = p;
+		return p;
+	}
+
+	void __destroy_node(Node* p)
+	{
+		range_destruct(p->__data(), p->__data() + p->m_count);
+		p->m_prev->m_next = p->m_next;
+		p->m_next->m_prev = p->m_prev;
+		NodeAllocator::deallocate(p);
+	}
+
+	// moves the upper half of full node 'p' into a new node after it
+	Node* __split(Node* p)
+	{
+		Node* q = __create_node(p);
+		T* data = p->__data();
+		size_type keep = N - __half;
+		range_move_construct(data + keep, data + N, q->__data());
+		range_destruct(data + keep, data + N);
+		p->m_count = keep;
+		q->m_count = __half;
+		return q;
+	}
+
+	// 'x' is a local copy, no element of this list
+	iterator __insert_value(iterator pos, T& x)
+	{
+		Node* p;
+		size_type i;
+		if (pos.m_node == &m_root)
+		{
+			// append to the last node or start a new one
+			p = __node(m_root.m_prev);
+			if (p == &m_root || p->m_count == N)
+				p = __create_node(m_root.m_prev);
+			i = p->m_count;
+		}
+		else
+		{
+			p = __node(pos.m_node);
+			i = pos.m_index;
+			if (p->m_count == N)
+			{
+				Node* q = __split(p);
+				if (i > p->m_count)
+				{
+					i -= p->m_count;
+					p = q;
+				}
+			}
+		}
+		T* data = p->__data();
+		size_type count = p->m_count;
+		if (i == count)
+			construct(data + count, MySTL::move(x));
+		else
+		{
+			construct(data + count, MySTL::move(data[count - 1]));
+			MySTL::move_backward(data + i, data + count - 1, data + count);
+			data[i] = MySTL::move(x);
+		}
+		++p->m_count;
+		++m_size;
+		return iterator(p, i);
+	}
+
+	// refills node 'p' after an erase at index 'i', returns the iterator to
+	// the element that followed the erased one
+	iterator __rebalance(Node* p, size_type i)
+	{
+		__unrolled_node_base* next = p->m_next;
+		if (p->m_count == 0)
+		{
+			__destroy_node(p);
+			return iterator(next, 0);
+		}
+		if (p->m_count < (size_type)__half && next != &m_root)
+		{
+			Node* q = __node(next);
+			T* data = p->__data();
+			T* qdata = q->__data();
+			if (p->m_count + q->m_count <= N)
+			{
+				range_move_construct(qdata, qdata + q->m_count, data + p->m_count);
+				p->m_count += q->m_count;
+				__destroy_node(q);
+			}
+			else
+			{
+				construct(data + p->m_count, MySTL::move(qdata[0]));
+				++p->m_count;
+				MySTL::move(qdata + 1, qdata + q->m_count, qdata);
+				destruct(qdata + --q->m_count);
+			}
+		}
+		if (i == p->m_count)
+			return iterator(p->m_next, 0);
+		return iterator(p, i);
+	}
+
+	void __initialize_empty()
+	{
+		m_root.m_next = m_root.m_prev = &m_root;
+		m_size = 0;
+	}
+
+	template <class Integer>
+	void __insert_aux(iterator pos, Integer n, Integer x, true_type)
+	{
+		for ( ; n > 0; --n)
+			pos = ++insert(pos, x);
+	}
+	template <class InputIterator>
+	void __insert_aux(iterator pos, InputIterator first, InputIterator last, false_type)
+	{
+		for ( ; first != last; ++first)
+			pos = ++insert(pos, *first);
+	}
+
+public:
+	unrolled_list() { __initialize_empty(); }
+	unrolled_list(size_type n, const T& x)
+	{
+		__initialize_empty();
+		insert(end(), n, x);
+	}
+	explicit unrolled_list(size_type n)
+	{
+		__initialize_empty();
+		insert(end(), n, T());
+	}
+	template <class InputIterator>
+	unrolled_list(InputIterator first, InputIterator last)
+	{
+		__initialize_empty();
+		insert(end(), first, last);
+	}
+	unrolled_list(const unrolled_list& x)
+	{
+		__initialize_empty();
+		insert(end(), x.begin(), x.end());
+	}
+#if defined(__MYSTL_CXX11)
+	unrolled_list(unrolled_list&& x)
+	{
+		__initialize_empty();
+		swap(x);
+	}
+#endif
+	~unrolled_list() { clear(); }
+
+	unrolled_list& operator=(const unrolled_list& x)
+	{
+		if (this != &x)
+		{
+			unrolled_list tmp(x);
+			swap(tmp);
+		}
+		return *this;
+	}
+#if defined(__MYSTL_CXX11)
+	unrolled_list& operator=(unrolled_list&& x)
+	{
+		swap(x);
+		return *this;
+	}
+#endif
+
+	iterator begin() { return iterator(m_root.m_next, 0); }
+	const_iterator begin() const { return const_iterator(m_root.m_next, 0); }
+	iterator end() { return iterator(&m_root, 0); }
+	const_iterator end() const { return const_iterator(__root(), 0); }
+
+	size_type size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	// elements per node
+	static size_type node_capacity() { return N; }
+
+	reference front() { return *begin(); }
+	const_reference front() const { return *begin(); }
+	reference back() { return *--end(); }
+	const_reference back() const { return *--end(); }
+
+	// returns the iterator to the new element
+	iterator insert(iterator pos, const T& x)
+	{
+		T x_copy = x;
+		return __insert_value(pos, x_copy);
+	}
+	void insert(iterator pos, size_type n, const T& x) { __insert_aux(pos, n, x, true_type()); }
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last)
+	{
+		typedef typename is_integer<InputIterator>::integer is_int;
+		__insert_aux(pos, first, last, is_int());
+	}
+	void push_back(const T& x)
+	{
+		Node* p = __node(m_root.m_prev);
+		if (p == &m_root || p->m_count == N)
+			p = __create_node(m_root.m_prev);
+		construct(p->__data() + p->m_count, x);
+		++p->m_count;
+		++m_size;
+	}
+	void push_front(const T& x) { insert(begin(), x); }
+#if defined(__MYSTL_CXX11)
+	iterator insert(iterator pos, T&& x)
+	{
+		T x_copy(MySTL::move(x));
+		return __insert_value(pos, x_copy);
+	}
+	void push_back(T&& x) { insert(end(), MySTL::move(x)); }
+#endif
+
+	iterator erase(iterator pos)
+	{
+		Node* p = __node(pos.m_node);
+		T* data = p->__data();
+		MySTL::move(data + pos.m_index + 1, data + p->m_count, data + pos.m_index);
+		destruct(data + --p->m_count);
+		--m_size;
+		return __rebalance(p, pos.m_index);
+	}
+	iterator erase(iterator first, iterator last)
+	{
+		size_type n = 0;
+		for (iterator i = first; i != last; ++i)
+			++n;
+		for ( ; n > 0; --n)
+			first = erase(first);
+		return first;
+	}
+	void pop_back() { erase(--end()); }
+	void pop_front() { erase(begin()); }
+
+	void clear()
+	{
+		while (m_root.m_next != &m_root)
+			__destroy_node(__node(m_root.m_next));
+		m_size = 0;
+	}
+
+	void swap(unrolled_list& x)
+	{
+		MySTL::swap(m_root, x.m_root);
+		MySTL::swap(m_size, x.m_size);
+		// the end nodes point back at the other object's root
+		if (m_root.m_next == &x.m_root)
+			m_root.m_next = m_root.m_prev = &m_root;
+		else
+			m_root.m_next->m_prev = m_root.m_prev->m_next = &m_root;
+		if (x.m_root.m_next == &m_root)
+			x.m_root.m_next = x.m_root.m_prev = &x.m_root;
+		else
+			x.m_root.m_next->m_prev = x.m_root.m_prev->m_next = &x.m_root;
+	}
+};
+
+__NS_END
@@ -22,14 +22,19 @@ public:
 	
 	typedef T* iterator;
 	typedef const T* const_iterator;
+	typedef Alloc allocator_type;
 
 	// initialize
 	vector(void);
-	vector(size_type n, const T& x);
+	explicit vector(const Alloc& a);
+	vector(size_type n, const T& x, const Alloc& a = Alloc());
 	explicit vector(size_type n);
 	vector(const vector<T,Alloc>& other);
 	template <class InputIterator>
-	vector(InputIterator first, InputIterator last);
+	vector(InputIterator first, InputIterator last, const Alloc& a = Alloc());
+#if defined(__MYSTL_CXX11)
+	vector(vector<T, Alloc>&& other) noexcept;
+#endif
 
 	// destruct
 	~vector();
@@ -44,6 +49,7 @@ public:
 	bool empty() const;
 	reference front();
 	const_reference front() const;
+	allocator_type get_allocator() const;
 
 	// insert
 	void insert(iterator pos, const T& x);
@@ -52,6 +58,14 @@ public:
 	void insert(iterator pos, size_type n, const T& x);
 	template <class InputIterator>
 	void insert(iterator pos, InputIterator first, InputIterator last);
+#if defined(__MYSTL_CXX11)
+	void insert(iterator pos, T&& x);
+	void push_back(T&& x);
+	template <class... Args>
+	iterator emplace(iterator pos, Args&&... args);
+	template <class... Args>
+	void emplace_back(Args&&... args);
+#endif
 
 	// erase
 	iterator erase(iterator pos);
@@ -69,6 +83,9 @@ public:
 	template <class InputIterator>
 	void assign(InputIterator first, InputIterator last);
 	vector<T, Alloc>& operator=(const vector<T, Alloc>& other);
+#if defined(__MYSTL_CXX11)
+	vector<T, Alloc>& operator=(vector<T, Alloc>&& other) noexcept;
+#endif
 
 	// swap
 	void swap(vector<T, Alloc>& other);
@@ -79,7 +96,13 @@ public:
 private:
 	T* m_start;
 	T* m_finish;
-	T* m_end_of_storage;
+	// the end of the storage together with the allocator
+	__alloc_pair<Alloc, T*> m_end_of_storage;
+
+	T*& __end_of_storage() { return m_end_of_storage.m_value; }
+	T* __end_of_storage() const { return m_end_of_storage.m_value; }
+	Alloc& __alloc() { return m_end_of_storage.__alloc(); }
+	const Alloc& __alloc() const { return m_end_of_storage.__alloc(); }
 
 	// initialize 
 	void __fill_initialize(size_type n, const T& x);
@@ -113,8 +136,25 @@ private:
 	void __assign_aux(InputIterator first, InputIterator last, true_type);
 	template <class InputIterator>
 	void __assign_aux(InputIterator first, InputIterator last, false_type);
+
+#if defined(__MYSTL_CXX11)
+	template <class... Args>
+	void __emplace_realloc(iterator pos, Args&&... args);
+#endif
+
+	// bitwise relocation, only for trivially relocatable elements
+	static bool __relocatable();
+	void __realloc_storage(size_type new_cap);
+	void __close_gap(iterator pos, size_type n);
 };
 
 #include "vector_impl.h"
 
+// only pointers to the heap block
+template <class T, class Alloc>
+struct is_trivially_relocatable<vector<T, Alloc> >
+{
+	typedef true_type type;
+};
+
 __NS_END
\ No newline at end of file
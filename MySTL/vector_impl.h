@@ -2,26 +2,32 @@
 
 template <class T, class Alloc>
 vector<T, Alloc>::vector(void)
-	:m_start(0), m_finish(0), m_end_of_storage(0)
+	:m_start(0), m_finish(0), m_end_of_storage(Alloc(), 0)
 {}
 
 template <class T, class Alloc>
-vector<T, Alloc>::vector(size_type n, const T& x)
-	:m_start(0), m_finish(0), m_end_of_storage(0)
+vector<T, Alloc>::vector(const Alloc& a)
+	:m_start(0), m_finish(0), m_end_of_storage(a, 0)
+{}
+
+template <class T, class Alloc>
+vector<T, Alloc>::vector(size_type n, const T& x, const Alloc& a)
+	:m_start(0), m_finish(0), m_end_of_storage(a, 0)
 {
 	__fill_initialize(n, x);
 }
 
 template <class T, class Alloc>
 vector<T, Alloc>::vector(size_type n)
-	:m_start(0), m_finish(0), m_end_of_storage(0)
+	:m_start(0), m_finish(0), m_end_of_storage(Alloc(), 0)
 {
 	__fill_initialize(n, T());
 }
 
 template <class T, class Alloc>
 template <class InputIterator>
-vector<T, Alloc>::vector(InputIterator first, InputIterator last)
+vector<T, Alloc>::vector(InputIterator first, InputIterator last, const Alloc& a)
+	:m_start(0), m_finish(0), m_end_of_storage(a, 0)
 {
 	typedef typename is_integer<InputIterator>::integer is_int;
 	__initialize_aux(first, last, is_int());
@@ -29,15 +35,26 @@ vector<T, Alloc>::vector(InputIterator first, InputIterator last)
 
 template <class T, class Alloc>
 vector<T, Alloc>::vector(const vector<T, Alloc>& other)
+	:m_start(0), m_finish(0), m_end_of_storage(other.__alloc(), 0)
 {
 	__range_initialize(other.begin(), other.end(), forward_iterator_tag());
 }
+
+#if defined(__MYSTL_CXX11)
+template <class T, class Alloc>
+vector<T, Alloc>::vector(vector<T, Alloc>&& other) noexcept
+	:m_start(other.m_start), m_finish(other.m_finish), 
+	m_end_of_storage(other.__alloc(), other.__end_of_storage())
+{
+	other.m_start = other.m_finish = other.__end_of_storage() = 0;
+}
+#endif
 	
 template <class T, class Alloc>
 vector<T, Alloc>::~vector()
 {
 	erase(m_start, m_finish);
-	Alloc::deallocate(m_start, m_end_of_storage - m_start);
+	__alloc().deallocate(m_start, __end_of_storage() - m_start);
 }
 
 template <class T, class Alloc>
@@ -73,7 +90,7 @@ typename vector<T, Alloc>::size_type vector<T, Alloc>::size() const
 template <class T, class Alloc>
 typename vector<T, Alloc>::size_type vector<T, Alloc>::capacity() const 
 {
-	return m_end_of_storage - m_start; 
+	return __end_of_storage() - m_start; 
 }
 
 template <class T, class Alloc>
@@ -94,12 +111,18 @@ typename vector<T, Alloc>::const_reference vector<T, Alloc>::front() const
 	return *begin();
 }
 
+template <class T, class Alloc>
+typename vector<T, Alloc>::allocator_type vector<T, Alloc>::get_allocator() const
+{
+	return __alloc();
+}
+
 
 template <class T, class Alloc>
 void vector<T, Alloc>::__fill_initialize(size_type n, const T& x)
 {
-	m_start = Alloc::allocate(n);
-	m_end_of_storage = m_start + n;
+	m_start = __alloc().allocate(n);
+	__end_of_storage() = m_start + n;
 	m_finish = fill_construct_n(m_start, n, x);
 }
 
@@ -115,9 +138,9 @@ template <class T, class Alloc>
 template <class ForwardIterator>
 void vector<T, Alloc>::__range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
-	size_type n = distance(first, last);
-	m_start = Alloc::allocate(n);
-	m_end_of_storage = m_start + n;
+	size_type n = MySTL::distance(first, last);
+	m_start = __alloc().allocate(n);
+	__end_of_storage() = m_start + n;
 	m_finish = range_construct(first, last, m_start);
 }
 
@@ -138,35 +161,50 @@ void vector<T, Alloc>::__initialize_aux(InputIterator first, InputIterator last,
 template <class T, class Alloc>
 void vector<T, Alloc>::insert(iterator pos, const T& x)
 {
-	if (m_finish != m_end_of_storage)
+	if (m_finish != __end_of_storage())
 	{
 		if (pos == m_finish)
 		{
 			construct(m_finish, x);
 			++m_finish;
 		}
+		else if (__relocatable())
+		{
+			T x_copy = x;
+			__relocation_gap<T> gap(pos, 1, m_finish);
+			construct(pos, MySTL::move(x_copy));
+			gap.__fill();
+		}
 		else
 		{
-			construct(m_finish , *(m_finish - 1));
-			++m_finish;
 			T x_copy = x;
-			copy_backward(pos, m_finish - 2, m_finish - 1);
-			*pos = x_copy;
+			construct(m_finish, MySTL::move(*(m_finish - 1)));
+			++m_finish;
+			MySTL::move_backward(pos, m_finish - 2, m_finish - 1);
+			*pos = MySTL::move(x_copy);
 		}
 	}
 	else
 	{
 		size_type new_sz = (size() == 0) ? 1 : 2 * size();
-		iterator new_start = Alloc::allocate(new_sz);
-		iterator new_finish = range_construct(m_start, pos, new_start);
-		construct(new_finish, x);
+		if (__relocatable())
+		{
+			T x_copy = x;
+			size_type index = pos - m_start;
+			__realloc_storage(new_sz);
+			insert(m_start + index, x_copy);
+			return;
+		}
+		iterator new_start = __alloc().allocate(new_sz);
+		construct(new_start + (pos - m_start), x);
+		iterator new_finish = range_move_construct(m_start, pos, new_start);
 		++new_finish;
-		new_finish = range_construct(pos, m_finish, new_finish);
+		new_finish = range_move_construct(pos, m_finish, new_finish);
 		range_destruct(m_start, m_finish);
-		Alloc::deallocate(m_start, m_finish - m_start);
+		__alloc().deallocate(m_start, __end_of_storage() - m_start);
 		m_start = new_start;
 		m_finish = new_finish;
-		m_end_of_storage = new_start + new_sz;
+		__end_of_storage() = new_start + new_sz;
 	}
 }
 
@@ -182,26 +220,117 @@ void vector<T, Alloc>::push_front(const T& x)
 	insert(begin(), x);
 }
 
+#if defined(__MYSTL_CXX11)
+template <class T, class Alloc>
+void vector<T, Alloc>::insert(iterator pos, T&& x)
+{
+	emplace(pos, MySTL::move(x));
+}
+
+template <class T, class Alloc>
+void vector<T, Alloc>::push_back(T&& x)
+{
+	emplace(end(), MySTL::move(x));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+typename vector<T, Alloc>::iterator vector<T, Alloc>::emplace(iterator pos, Args&&... args)
+{
+	size_type index = pos - m_start;
+	if (m_finish == __end_of_storage())
+		__emplace_realloc(pos, MySTL::forward<Args>(args)...);
+	else if (pos == m_finish)
+	{
+		construct(m_finish, MySTL::forward<Args>(args)...);
+		++m_finish;
+	}
+	else if (__relocatable())
+	{
+		T x_copy(MySTL::forward<Args>(args)...);
+		__relocation_gap<T> gap(pos, 1, m_finish);
+		construct(pos, MySTL::move(x_copy));
+		gap.__fill();
+	}
+	else
+	{
+		// the arguments may refer to elements that are about to move
+		T x_copy(MySTL::forward<Args>(args)...);
+		construct(m_finish, MySTL::move(*(m_finish - 1)));
+		++m_finish;
+		MySTL::move_backward(pos, m_finish - 2, m_finish - 1);
+		*pos = MySTL::move(x_copy);
+	}
+	return m_start + index;
+}
+
+template <class T, class Alloc>
+template <class... Args>
+void vector<T, Alloc>::emplace_back(Args&&... args)
+{
+	if (m_finish != __end_of_storage())
+	{
+		construct(m_finish, MySTL::forward<Args>(args)...);
+		++m_finish;
+	}
+	else
+		__emplace_realloc(m_finish, MySTL::forward<Args>(args)...);
+}
+
+// the new element is constructed before the old ones are moved, the
+// arguments may refer to them
+template <class T, class Alloc>
+template <class... Args>
+void vector<T, Alloc>::__emplace_realloc(iterator pos, Args&&... args)
+{
+	size_type new_sz = (size() == 0) ? 1 : 2 * size();
+	size_type index = pos - m_start;
+	if (__relocatable())
+	{
+		T x_copy(MySTL::forward<Args>(args)...);
+		__realloc_storage(new_sz);
+		emplace(m_start + index, MySTL::move(x_copy));
+		return;
+	}
+	iterator new_start = __alloc().allocate(new_sz);
+	construct(new_start + index, MySTL::forward<Args>(args)...);
+	range_move_construct(m_start, pos, new_start);
+	iterator new_finish = range_move_construct(pos, m_finish, new_start + index + 1);
+	range_destruct(m_start, m_finish);
+	__alloc().deallocate(m_start, __end_of_storage() - m_start);
+	m_start = new_start;
+	m_finish = new_finish;
+	__end_of_storage() = new_start + new_sz;
+}
+#endif
+
 template <class T, class Alloc>
 void vector<T, Alloc>::__fill_insert(iterator pos, size_type n, const T& x)
 {
 	if (n == 0)
 		return;
-	if (size_type(m_end_of_storage - m_finish) >= n)
+	if (size_type(__end_of_storage() - m_finish) >= n)
 	{
 		T x_copy = x;
+		if (__relocatable())
+		{
+			__relocation_gap<T> gap(pos, n, m_finish);
+			fill_construct_n(pos, n, x_copy);
+			gap.__fill();
+			return;
+		}
 		size_type elems_after = m_finish - pos;
 		if (elems_after >= n)
 		{
-			range_construct(m_finish - n, m_finish, m_finish);
-			MySTL::copy_backward(pos, m_finish - n, m_finish);
+			range_move_construct(m_finish - n, m_finish, m_finish);
+			MySTL::move_backward(pos, m_finish - n, m_finish);
 			MySTL::fill_n(pos, n, x_copy);
 			m_finish += n;	
 		}
 		else
 		{
 			iterator new_finish = fill_construct_n(m_finish, n - elems_after, x_copy);
-			new_finish = range_construct(pos, m_finish, new_finish);
+			new_finish = range_move_construct(pos, m_finish, new_finish);
 			MySTL::fill_n(pos, elems_after, x_copy);
 			m_finish = new_finish;
 		}
@@ -209,16 +338,25 @@ void vector<T, Alloc>::__fill_insert(iterator pos, size_type n, const T& x)
 	else
 	{
 		size_type old_sz = size();
-		size_type new_sz = old_sz + max(old_sz, n);
-		iterator new_start = Alloc::allocate(new_sz);
-		iterator new_finish = range_construct(m_start, pos, new_start);
-		new_finish = fill_construct_n(new_finish, n, x);
-		new_finish = range_construct(pos, m_finish, new_finish);
+		size_type new_sz = old_sz + MySTL::max(old_sz, n);
+		if (__relocatable())
+		{
+			T x_copy = x;
+			size_type index = pos - m_start;
+			__realloc_storage(new_sz);
+			__fill_insert(m_start + index, n, x_copy);
+			return;
+		}
+		iterator new_start = __alloc().allocate(new_sz);
+		iterator new_finish = new_start + (pos - m_start);
+		fill_construct_n(new_finish, n, x);
+		range_move_construct(m_start, pos, new_start);
+		new_finish = range_move_construct(pos, m_finish, new_finish + n);
 		range_destruct(m_start, m_finish);
-		Alloc::deallocate(m_start, m_end_of_storage - m_start);
+		__alloc().deallocate(m_start, __end_of_storage() - m_start);
 		m_start = new_start;
 		m_finish = new_finish;
-		m_end_of_storage = m_start + new_sz;
+		__end_of_storage() = m_start + new_sz;
 	}
 }
 
@@ -245,40 +383,54 @@ void vector<T, Alloc>::__range_insert(iterator pos, ForwardIterator first, Forwa
 {
 	if (first == last)
 		return;
-	size_type n = distance(first, last);
-	if (size_type(m_end_of_storage - m_finish) >= n)
+	size_type n = MySTL::distance(first, last);
+	if (size_type(__end_of_storage() - m_finish) >= n)
 	{
+		if (__relocatable())
+		{
+			__relocation_gap<T> gap(pos, n, m_finish);
+			range_construct(first, last, pos);
+			gap.__fill();
+			return;
+		}
 		size_type elems_after = m_finish - pos;
 		if (elems_after >= n)
 		{
-			range_construct(m_finish - n, m_finish, m_finish);
-			copy_backward(pos, m_finish - n, m_finish);
+			range_move_construct(m_finish - n, m_finish, m_finish);
+			MySTL::move_backward(pos, m_finish - n, m_finish);
 			m_finish += n;	
-			copy(first, last, pos);
+			MySTL::copy(first, last, pos);
 		}
 		else
 		{
 			ForwardIterator mid = first;
-			advance(mid, elems_after);
+			MySTL::advance(mid, elems_after);
 			iterator new_finish = range_construct(mid, last, m_finish);
-			new_finish = range_construct(pos, m_finish, new_finish);
+			new_finish = range_move_construct(pos, m_finish, new_finish);
 			m_finish = new_finish;
-			copy(first, mid, pos);
+			MySTL::copy(first, mid, pos);
 		}
 	}
 	else
 	{
 		size_type old_sz = size();
-		size_type new_sz = old_sz + max(old_sz, n);
-		iterator new_start = Alloc::allocate(new_sz);
-		iterator new_finish = range_construct(m_start, pos, new_start);
+		size_type new_sz = old_sz + MySTL::max(old_sz, n);
+		if (__relocatable())
+		{
+			size_type index = pos - m_start;
+			__realloc_storage(new_sz);
+			__range_insert(m_start + index, first, last, forward_iterator_tag());
+			return;
+		}
+		iterator new_start = __alloc().allocate(new_sz);
+		iterator new_finish = range_move_construct(m_start, pos, new_start);
 		new_finish = range_construct(first, last, new_finish);
-		new_finish = range_construct(pos, m_finish, new_finish);
+		new_finish = range_move_construct(pos, m_finish, new_finish);
 		range_destruct(m_start, m_finish);
-		Alloc::deallocate(m_start, m_end_of_storage - m_start);
+		__alloc().deallocate(m_start, __end_of_storage() - m_start);
 		m_start = new_start;
 		m_finish = new_finish;
-		m_end_of_storage = m_start + new_sz;
+		__end_of_storage() = m_start + new_sz;
 	}
 }
 
@@ -307,8 +459,14 @@ void vector<T, Alloc>::insert(iterator pos, InputIterator first, InputIterator l
 template <class T, class Alloc>
 typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator pos)
 {
+	if (__relocatable())
+	{
+		destruct(pos);
+		__close_gap(pos, 1);
+		return pos;
+	}
 	if (pos != m_finish - 1)
-		copy(pos + 1, m_finish, pos);
+		MySTL::move(pos + 1, m_finish, pos);
 	--m_finish;
 	destruct(m_finish);
 	return pos;
@@ -317,7 +475,13 @@ typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator pos)
 template <class T, class Alloc>
 typename vector<T, Alloc>::iterator vector<T, Alloc>::erase(iterator first, iterator last)
 {
-	iterator new_finish = MySTL::copy(last, m_finish, first);
+	if (__relocatable())
+	{
+		range_destruct(first, last);
+		__close_gap(first, last - first);
+		return first;
+	}
+	iterator new_finish = MySTL::move(last, m_finish, first);
 	range_destruct(new_finish, m_finish);
 	m_finish = new_finish;
 	return first;
@@ -338,16 +502,23 @@ void vector<T, Alloc>::clear()
 template <class T, class Alloc>
 void vector<T, Alloc>::resize(size_type new_sz, const T& x)
 {
-	if (new_sz > capacity())
+	if (new_sz > capacity() && __relocatable())
+	{
+		T x_copy = x;
+		__realloc_storage(new_sz);
+		fill_construct(m_finish, m_start + new_sz, x_copy);
+		m_finish = m_start + new_sz;
+	}
+	else if (new_sz > capacity())
 	{
-		iterator new_start = Alloc::allocate(new_sz);
-		iterator i = range_construct(m_start, m_finish, new_start);
-		fill_construct(i, new_start + new_sz, x);
+		iterator new_start = __alloc().allocate(new_sz);
+		fill_construct(new_start + size(), new_start + new_sz, x);
+		range_move_construct(m_start, m_finish, new_start);
 		range_destruct(m_start, m_finish);
-		Alloc::deallocate(m_start, m_end_of_storage - m_start);
+		__alloc().deallocate(m_start, __end_of_storage() - m_start);
 		m_start = new_start;
 		m_finish = new_start + new_sz;
-		m_end_of_storage = m_finish;
+		__end_of_storage() = m_finish;
 	}
 	else
 	{
@@ -375,14 +546,19 @@ void vector<T, Alloc>::reserve(size_type new_sz)
 {
 	if (capacity() >= new_sz)
 		return;
-	iterator new_start = Alloc::allocate(new_sz);
-	range_construct(m_start, m_finish, new_start);
+	if (__relocatable())
+	{
+		__realloc_storage(new_sz);
+		return;
+	}
+	iterator new_start = __alloc().allocate(new_sz);
+	range_move_construct(m_start, m_finish, new_start);
 	range_destruct(m_start, m_finish);
-	Alloc::deallocate(m_start, m_end_of_storage - m_start);
+	__alloc().deallocate(m_start, __end_of_storage() - m_start);
 	size_type old_sz = size();
 	m_start = new_start;
 	m_finish = new_start + old_sz;
-	m_end_of_storage = new_start + new_sz;
+	__end_of_storage() = new_start + new_sz;
 }
 
 template <class T, class Alloc>
@@ -392,18 +568,18 @@ void vector<T, Alloc>::__fill_assign(size_type n, const T& x)
 	{
 		if (n <= size())
 		{
-			iterator new_finish = fill_n(m_start, n, x);
+			iterator new_finish = MySTL::fill_n(m_start, n, x);
 			erase(new_finish, m_finish);
 		}
 		else
 		{
-			fill(m_start, m_finish, x);
+			MySTL::fill(m_start, m_finish, x);
 			m_finish = fill_construct_n(m_finish, n - size(), x);
 		}
 	}
 	else
 	{
-		vector<T, Alloc> tmp(n, x);
+		vector<T, Alloc> tmp(n, x, __alloc());
 		tmp.swap(*this);
 	}
 }
@@ -425,26 +601,26 @@ template <class T, class Alloc>
 template <class ForwardIterator>
 void vector<T, Alloc>::__range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
 {
-	size_type n = distance(first, last);
+	size_type n = MySTL::distance(first, last);
 	if (n <= capacity())
 	{
 		if (n <= size())
 		{
-			iterator new_finish = copy(first, last, m_start);
+			iterator new_finish = MySTL::copy(first, last, m_start);
 			range_destruct(new_finish, m_finish);
 			m_finish = new_finish;
 		}
 		else
 		{
 			ForwardIterator mid = first;
-			advance(mid, size());
-			copy(first, mid, m_start);
+			MySTL::advance(mid, size());
+			MySTL::copy(first, mid, m_start);
 			m_finish = range_construct(mid, last, m_finish);
 		}
 	}
 	else
 	{
-		vector<T, Alloc> tmp(first, last);
+		vector<T, Alloc> tmp(first, last, __alloc());
 		tmp.swap(*this);
 	}
 }
@@ -479,6 +655,24 @@ vector<T, Alloc>& vector<T, Alloc>::operator=(const vector<T, Alloc>& other)
 	return *this;
 }
 
+#if defined(__MYSTL_CXX11)
+template <class T, class Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(vector<T, Alloc>&& other) noexcept
+{
+	if (this != &other)
+	{
+		range_destruct(m_start, m_finish);
+		__alloc().deallocate(m_start, __end_of_storage() - m_start);
+		m_start = other.m_start;
+		m_finish = other.m_finish;
+		__end_of_storage() = other.__end_of_storage();
+		__alloc() = other.__alloc();
+		other.m_start = other.m_finish = other.__end_of_storage() = 0;
+	}
+	return *this;
+}
+#endif
+
 template <class T, class Alloc>
 void vector<T, Alloc>::swap(vector<T, Alloc>& other)
 {
@@ -497,4 +691,33 @@ template <class T, class Alloc>
 const T& vector<T, Alloc>::operator[](size_type index) const 
 {
 	return *(begin() + index); 
+}
+
+template <class T, class Alloc>
+bool vector<T, Alloc>::__relocatable()
+{
+	typedef typename is_trivially_relocatable<T>::type relocatable;
+	return __is_true(relocatable());
+}
+
+// keeps the elements where they are when the block can grow in place,
+// otherwise lets the allocator move them bitwise (realloc/mremap)
+template <class T, class Alloc>
+void vector<T, Alloc>::__realloc_storage(size_type new_cap)
+{
+	size_type old_cap = capacity();
+	size_type old_sz = size();
+	if (!__alloc().try_expand_in_place(m_start, old_cap, new_cap))
+		m_start = __alloc().reallocate(m_start, old_cap, new_cap);
+	m_finish = m_start + old_sz;
+	__end_of_storage() = m_start + new_cap;
+}
+
+// the 'n' elements at 'pos' are already destroyed
+template <class T, class Alloc>
+void vector<T, Alloc>::__close_gap(iterator pos, size_type n)
+{
+	if (pos + n != m_finish)
+		memmove((void*)pos, (void*)(pos + n), (m_finish - pos - n) * sizeof(T));
+	m_finish -= n;
 }
\ No newline at end of file
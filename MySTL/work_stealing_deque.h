@@ -0,0 +1,165 @@
+#pragma once
+
+// needs C++11: std::atomic
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include "config.h"
+#include "allocator.h"
+#include "concurrent_queue.h"
+
+__NS_BEGIN
+
+// a ring of 'm_mask + 1' slots, the arrays a deque outgrew stay chained
+// through 'm_prev' because a thief may still read from them
+template <class T>
+struct __ws_array
+{
+	size_t m_mask;
+	std::atomic<T>* m_slots;
+	__ws_array* m_prev;
+
+	T __get(ptrdiff_t i) const { return m_slots[i & m_mask].load(std::memory_order_relaxed); }
+	void __put(ptrdiff_t i, T x) { m_slots[i & m_mask].store(x, std::memory_order_relaxed); }
+};
+
+// Chase-Lev work stealing deque, with the memory orders of Le, Pop, Cohen
+// and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+// Models". One owner thread pushes and pops at the bottom, any number of
+// thieves steal from the top; only the last element is contended. The
+// owner never waits, a thief that loses a race returns false. The ring
+// doubles when it is full and never shrinks.
+//
+// Thieves read a slot before they know they own it, so T is copied as a
+// whole through std::atomic and must be trivially copyable: a pointer or
+// a small handle to the task, not the task itself. The top, which the
+// thieves write, and the owner's bottom are on cache lines of their own;
+// on the heap that takes C++17 aligned new.
+template <class T, class Alloc = allocator>
+class alignas(__MYSTL_CACHE_LINE) work_stealing_deque
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+
+private:
+	typedef __ws_array<T> Array;
+	typedef type_allocator<Array, Alloc> ArrayAllocator;
+	typedef type_allocator<std::atomic<T>, Alloc> SlotAllocator;
+
+	alignas(__MYSTL_CACHE_LINE) std::atomic<ptrdiff_t> m_top;
+	alignas(__MYSTL_CACHE_LINE) std::atomic<ptrdiff_t> m_bottom;
+	std::atomic<Array*> m_array;
+
+	work_stealing_deque(const work_stealing_deque<T, Alloc>&);
+	work_stealing_deque<T, Alloc>& operator=(const work_stealing_deque<T, Alloc>&);
+
+	static Array* __new_array(size_t slots, Array* prev)
+	{
+		Array* a = ArrayAllocator::allocate();
+		a->m_mask = slots - 1;
+		a->m_slots = SlotAllocator::allocate(slots);
+		for (size_t i = 0; i < slots; ++i)
+			new (&a->m_slots[i]) std::atomic<T>();
+		a->m_prev = prev;
+		return a;
+	}
+
+	// owner only: copies [top, bottom) into a ring twice the size
+	Array* __grow(Array* a, ptrdiff_t top, ptrdiff_t bottom)
+	{
+		Array* bigger = __new_array(2 * (a->m_mask + 1), a);
+		for (ptrdiff_t i = top; i < bottom; ++i)
+			bigger->__put(i, a->__get(i));
+		m_array.store(bigger, std::memory_order_release);
+		return bigger;
+	}
+
+public:
+	// starts with room for 'capacity' elements, rounded up to a power of two
+	explicit work_stealing_deque(size_type capacity = 64)
+		: m_top(0), m_bottom(0)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "work_stealing_deque needs a trivially copyable T");
+		m_array.store(__new_array(__queue_slots(capacity), 0), std::memory_order_relaxed);
+	}
+
+	~work_stealing_deque()
+	{
+		Array* a = m_array.load(std::memory_order_relaxed);
+		while (a)
+		{
+			Array* prev = a->m_prev;
+			SlotAllocator::deallocate(a->m_slots, a->m_mask + 1);
+			ArrayAllocator::deallocate(a);
+			a = prev;
+		}
+	}
+
+	size_type capacity() const { return m_array.load(std::memory_order_relaxed)->m_mask + 1; }
+	size_type size_approx() const
+	{
+		ptrdiff_t b = m_bottom.load(std::memory_order_relaxed);
+		ptrdiff_t t = m_top.load(std::memory_order_relaxed);
+		return b > t ? size_type(b - t) : 0;
+	}
+	bool empty_approx() const { return size_approx() == 0; }
+
+	// owner only
+	void push(T x)
+	{
+		ptrdiff_t b = m_bottom.load(std::memory_order_relaxed);
+		ptrdiff_t t = m_top.load(std::memory_order_acquire);
+		Array* a = m_array.load(std::memory_order_relaxed);
+		if (b - t > ptrdiff_t(a->m_mask))
+			a = __grow(a, t, b);
+		a->__put(b, x);
+		m_bottom.store(b + 1, std::memory_order_release);
+	}
+
+	// owner only: the most recently pushed element, false when empty
+	bool pop(T& out)
+	{
+		ptrdiff_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+		Array* a = m_array.load(std::memory_order_relaxed);
+		m_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		ptrdiff_t t = m_top.load(std::memory_order_relaxed);
+		if (t > b)
+		{
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+		out = a->__get(b);
+		if (t == b)
+		{
+			// the last element, a thief may be taking it as well
+			bool won = m_top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// any thread: the oldest element, false when empty or another thread
+	// took it first
+	bool steal(T& out)
+	{
+		ptrdiff_t t = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		ptrdiff_t b = m_bottom.load(std::memory_order_acquire);
+		if (t >= b)
+			return false;
+		Array* a = m_array.load(std::memory_order_acquire);
+		T x = a->__get(t);
+		if (!m_top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+		out = x;
+		return true;
+	}
+};
+
+__NS_END